@@ -0,0 +1,429 @@
+/*
+        Room-state bridge: dashboard fan-out and latency
+
+        Compares what a dashboard has to handle when it subscribes
+        to every node topic directly with what it handles behind
+        campus_bridge, which coalesces the same stream into at
+        most one message per building per period.
+
+        Offline (always): a campus of N rooms, 50 per building,
+        publishing what main.cpp publishes at adaptive-sampling
+        rates, is replayed through a RoomTable in snapshot and in
+        diff mode, flushed every 20 ms as the daemon does. Reports
+        per dashboard messages/s (wake-ups) and bytes/s on the
+        wire, the bridge's CPU cost per input message, and the
+        staleness the bridge adds: time from a reading changing to
+        the summary that carries it going out.
+
+        Online (--broker): the same model is published live to a
+        broker under bench/, a bridge thread runs a RoomTable on
+        it, and --dashboards clients of each kind subscribe, one
+        set to bench/# and one set to the summaries. A probe room
+        changes its Lx every 100 ms; each dashboard times how long
+        each value takes to reach it (or be replaced by a newer
+        one it receives), and measures its own CPU time, so
+        broker hops and JSON size are both included.
+
+          docker compose up mosquitto      (or: mosquitto -p 1883)
+          bridge_bench --rooms 1000 --broker 127.0.0.1:1883
+
+        Usage:
+          bridge_bench [--rooms N] [--minutes M] [--period MS]
+                       [--broker HOST:PORT] [--seconds S]
+                       [--dashboards D] [--diff|--snapshots]
+*/
+
+#include "CampusTraffic.hpp"
+#include "MqttClient.hpp"
+#include "RoomTable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unistd.h>
+#include <vector>
+
+// 2026-10-19 06:00 UTC
+#define START_MS 1792389600000LL
+
+#define ROOMS_PER_BUILDING 50
+
+// Flush cadence, as campus_bridge's poll timeout
+#define TICK_MS 20
+
+// Probe room for the online latency measurement
+#define PROBE_PERIOD_MS 100
+#define PROBE_BASE 100000
+#define PROBE_TOPIC "bench/bldg-0/probe/Lx"
+#define SUMMARY_PREFIX "bench-rooms"
+
+struct Options {
+  int rooms = 2000;
+  double minutes = 10;
+  int periodMs = BRIDGE_PERIOD_MS;
+  std::string brokerHost;
+  uint16_t brokerPort = 1883;
+  int seconds = 20;
+  int dashboards = 4;
+  bool diffs = true;
+};
+
+// Bytes of one QoS 0 PUBLISH on the wire
+static size_t wireBytes(size_t topicLen, size_t payloadLen) {
+  size_t body = 2 + topicLen + payloadLen;
+  size_t header = 2;
+  for (size_t n = body; n >= 128; n /= 128) {
+    header++;
+  }
+  return header + body;
+}
+
+static float percentile(std::vector<float> &v, double p) {
+  if (v.empty()) {
+    return 0;
+  }
+  size_t k = (size_t)(p * (v.size() - 1));
+  std::nth_element(v.begin(), v.begin() + k, v.end());
+  return v[k];
+}
+
+static int64_t threadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+        Offline: replay the stream through a RoomTable. The
+        direct figures are what a dashboard subscribed to every
+        node topic receives: each message, as is.
+*/
+static void runOffline(const Options &opt, bool diffs,
+                       const std::vector<std::string> &topics,
+                       bool printDirect) {
+  CampusTraffic traffic(opt.rooms, START_MS);
+  RoomTable table(opt.periodMs, diffs);
+
+  // Change times not yet carried by a summary, per building
+  size_t buildings = (opt.rooms + ROOMS_PER_BUILDING - 1) / ROOMS_PER_BUILDING;
+  std::vector<std::vector<int64_t>> pending(buildings);
+  std::unordered_map<std::string, size_t> buildingOf;
+  for (size_t b = 0; b < buildings; b++) {
+    buildingOf[std::string(BRIDGE_TOPIC_PREFIX "/bldg-") + std::to_string(b) +
+               (diffs ? "/diff" : "")] = b;
+  }
+
+  uint64_t in = 0, inBytes = 0, out = 0, outBytes = 0, carried = 0;
+  std::vector<float> staleness;
+  int64_t now = START_MS;
+  RoomTable::PublishHandler publish = [&](const std::string &topic,
+                                          const std::string &json, bool) {
+    out++;
+    outBytes += wireBytes(topic.size(), json.size());
+    auto b = buildingOf.find(topic);
+    if (b == buildingOf.end()) {
+      return; // Periodic retained snapshot in diff mode
+    }
+    for (int64_t t : pending[b->second]) {
+      staleness.push_back((float)(now - t));
+    }
+    carried += pending[b->second].size();
+    pending[b->second].clear();
+  };
+
+  std::vector<TrafficMessage> batch;
+  int64_t end = START_MS + (int64_t)(opt.minutes * 60000);
+  int64_t ns = 0;
+  for (int64_t t = START_MS; t < end; t += 1000) {
+    traffic.generate(t, batch);
+    size_t i = 0;
+    for (now = t; now < t + 1000; now += TICK_MS) {
+      int64_t t0 = monotonicNs();
+      for (; i < batch.size() && batch[i].time < now + TICK_MS; i++) {
+        const TrafficMessage &m = batch[i];
+        const std::string &topic = topics[m.topic];
+        if (table.update(topic.data(), topic.size(),
+                         reinterpret_cast<const uint8_t *>(m.payload), m.len,
+                         now)) {
+          size_t room = m.topic / TRAFFIC_METRICS;
+          pending[room / ROOMS_PER_BUILDING].push_back(m.time);
+        }
+        in++;
+        inBytes += wireBytes(topic.size(), m.len);
+      }
+      table.flush(now + TICK_MS, publish);
+      ns += monotonicNs() - t0;
+    }
+  }
+
+  double seconds = opt.minutes * 60;
+  if (printDirect) {
+    printf("%-22s %10.1f %10.1f %10s %10s %10s\n", "direct (all topics)",
+           in / seconds, inBytes / seconds / 1024, "-", "0", "0");
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "bridge, %s", diffs ? "diffs" : "snapshots");
+  printf("%-22s %10.1f %10.1f %10.0f %10.0f %10.0f\n", name, out / seconds,
+         outBytes / seconds / 1024, (double)ns / in,
+         percentile(staleness, 0.5), percentile(staleness, 1.0));
+  if (!diffs) {
+    printf("  %llu changes, %llu unchanged readings absorbed, %llu changes "
+           "carried\n",
+           (unsigned long long)table.changes(),
+           (unsigned long long)table.unchanged(),
+           (unsigned long long)carried);
+  }
+}
+
+struct Dashboard {
+  bool bridged;
+  MqttClient client;
+  uint64_t messages = 0, bytes = 0;
+  int64_t cpuNs = 0;
+  int lastProbe = -1;
+  std::vector<float> latencyMs;
+};
+
+// Probe value carried by a summary, or -1
+static int probeInSummary(const uint8_t *payload, size_t len) {
+  static const char room[] = "\"probe\":{";
+  const char *p = static_cast<const char *>(
+      memmem(payload, len, room, sizeof(room) - 1));
+  if (!p) {
+    return -1;
+  }
+  const char *end = reinterpret_cast<const char *>(payload) + len;
+  const char *close = static_cast<const char *>(memchr(p, '}', end - p));
+  const char *lx = static_cast<const char *>(
+      memmem(p, close ? close - p : end - p, "\"Lx\":", 5));
+  return lx ? atoi(lx + 5) - PROBE_BASE : -1;
+}
+
+/*
+        Online: the same model, live through a broker. Returns
+        false if the broker is unreachable.
+*/
+static bool runOnline(const Options &opt) {
+  std::vector<std::string> topics =
+      CampusTraffic::topics(opt.rooms, ROOMS_PER_BUILDING, "bench/");
+  uint32_t probeTopic = (uint32_t)topics.size();
+  topics.push_back(PROBE_TOPIC);
+
+  size_t probes = (size_t)opt.seconds * 1000 / PROBE_PERIOD_MS + 1;
+  std::unique_ptr<std::atomic<int64_t>[]> sentNs(
+      new std::atomic<int64_t>[probes]);
+  std::atomic<bool> stop(false);
+  std::string id = std::to_string(getpid());
+
+  std::vector<std::unique_ptr<Dashboard>> dashboards;
+  for (int i = 0; i < 2 * opt.dashboards; i++) {
+    dashboards.emplace_back(new Dashboard());
+    Dashboard &d = *dashboards.back();
+    d.bridged = i >= opt.dashboards;
+    if (!d.client.connect(opt.brokerHost, opt.brokerPort,
+                          "bench-dash-" + id + "-" + std::to_string(i)) ||
+        !d.client.subscribe(d.bridged ? SUMMARY_PREFIX "/#" : "bench/#")) {
+      fprintf(stderr, "broker %s:%u unavailable\n", opt.brokerHost.c_str(),
+              opt.brokerPort);
+      return false;
+    }
+  }
+
+  MqttClient bridgeClient, publisher;
+  if (!bridgeClient.connect(opt.brokerHost, opt.brokerPort,
+                            "bench-bridge-" + id) ||
+      !bridgeClient.subscribe("bench/#") ||
+      !publisher.connect(opt.brokerHost, opt.brokerPort, "bench-pub-" + id)) {
+    fprintf(stderr, "broker %s:%u unavailable\n", opt.brokerHost.c_str(),
+            opt.brokerPort);
+    return false;
+  }
+
+  std::vector<std::thread> threads;
+  for (auto &dp : dashboards) {
+    Dashboard *d = dp.get();
+    threads.emplace_back([d, &stop, &sentNs, probes]() {
+      MqttClient::MessageHandler onMessage =
+          [&](const char *topic, size_t topicLen, const uint8_t *payload,
+              size_t payloadLen) {
+            int64_t now = monotonicNs();
+            d->messages++;
+            d->bytes += wireBytes(topicLen, payloadLen);
+            int k = -1;
+            if (d->bridged) {
+              k = probeInSummary(payload, payloadLen);
+            } else if (topicLen == sizeof(PROBE_TOPIC) - 1 &&
+                       !memcmp(topic, PROBE_TOPIC, topicLen)) {
+              k = atoi(std::string((const char *)payload, payloadLen).c_str()) -
+                  PROBE_BASE;
+            }
+            // A newer value also delivers the ones it replaced; snapshots
+            // repeat the value, so count only its first sighting
+            if (k > d->lastProbe && (size_t)k < probes) {
+              for (int j = d->lastProbe + 1; j <= k; j++) {
+                d->latencyMs.push_back((now - sentNs[j].load()) / 1e6f);
+              }
+              d->lastProbe = k;
+            }
+          };
+      int64_t t0 = threadCpuNs();
+      while (!stop.load() && d->client.poll(50, onMessage)) {
+      }
+      d->cpuNs = threadCpuNs() - t0;
+    });
+  }
+
+  int64_t bridgeCpuNs = 0;
+  uint64_t bridgeIn = 0;
+  threads.emplace_back([&]() {
+    RoomTable table(opt.periodMs, opt.diffs, SUMMARY_PREFIX);
+    MqttClient::MessageHandler onMessage =
+        [&](const char *topic, size_t topicLen, const uint8_t *payload,
+            size_t payloadLen) {
+          table.update(topic, topicLen, payload, payloadLen, realtimeMs());
+          bridgeIn++;
+        };
+    RoomTable::PublishHandler publish = [&](const std::string &topic,
+                                            const std::string &json,
+                                            bool retain) {
+      bridgeClient.publish(topic, json.data(), json.size(), retain);
+    };
+    int64_t t0 = threadCpuNs();
+    while (!stop.load() && bridgeClient.poll(TICK_MS, onMessage)) {
+      table.flush(realtimeMs(), publish);
+    }
+    bridgeCpuNs = threadCpuNs() - t0;
+  });
+
+  // Publisher: the model in real time, plus the probe
+  CampusTraffic traffic(opt.rooms, 0);
+  std::vector<TrafficMessage> batch;
+  int64_t base = monotonicMs();
+  uint64_t published = 0;
+  for (int64_t t = 0; t < opt.seconds * 1000LL; t += 1000) {
+    traffic.generate(t, batch);
+    for (int64_t p = t; p < t + 1000; p += PROBE_PERIOD_MS) {
+      CampusTraffic::emit(batch, probeTopic, p, "%.0f",
+                          PROBE_BASE + p / PROBE_PERIOD_MS);
+    }
+    std::stable_sort(batch.begin(), batch.end(),
+                     [](const TrafficMessage &a, const TrafficMessage &b) {
+                       return a.time < b.time;
+                     });
+    for (const TrafficMessage &m : batch) {
+      int64_t wait = base + m.time - monotonicMs();
+      if (wait > 0) {
+        usleep((useconds_t)wait * 1000);
+      }
+      if (m.topic == probeTopic) {
+        sentNs[atoi(m.payload) - PROBE_BASE].store(monotonicNs());
+      }
+      publisher.publish(topics[m.topic], m.payload, m.len);
+      published++;
+    }
+  }
+
+  // Let the last period drain
+  usleep((useconds_t)(opt.periodMs + 500) * 1000);
+  stop.store(true);
+  for (std::thread &t : threads) {
+    t.join();
+  }
+  publisher.disconnect();
+  bridgeClient.disconnect();
+
+  printf("\n== online: %d rooms via %s:%u, %d s, %llu messages published, "
+         "%d dashboards each ==\n",
+         opt.rooms, opt.brokerHost.c_str(), opt.brokerPort, opt.seconds,
+         (unsigned long long)published, opt.dashboards);
+  printf("%-22s %10s %10s %10s %8s %8s %8s\n", "per dashboard", "msg/s",
+         "KiB/s", "CPU ms/s", "p50 ms", "p99 ms", "max ms");
+  for (int bridged = 0; bridged < 2; bridged++) {
+    uint64_t messages = 0, bytes = 0;
+    int64_t cpu = 0;
+    std::vector<float> latency;
+    for (auto &d : dashboards) {
+      if (d->bridged != (bool)bridged) {
+        continue;
+      }
+      messages += d->messages;
+      bytes += d->bytes;
+      cpu += d->cpuNs;
+      latency.insert(latency.end(), d->latencyMs.begin(), d->latencyMs.end());
+      d->client.disconnect();
+    }
+    double scale = 1.0 / opt.dashboards / opt.seconds;
+    printf("%-22s %10.1f %10.1f %10.2f %8.1f %8.1f %8.1f\n",
+           bridged ? (opt.diffs ? "bridge, diffs" : "bridge, snapshots")
+                   : "direct (all topics)",
+           messages * scale, bytes * scale / 1024, cpu * scale / 1e6,
+           percentile(latency, 0.5), percentile(latency, 0.99),
+           percentile(latency, 1.0));
+  }
+  printf("bridge: %llu messages in, %.2f CPU ms/s\n",
+         (unsigned long long)bridgeIn, bridgeCpuNs / 1e6 / opt.seconds);
+  return true;
+}
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--rooms") && hasValue) {
+      opt.rooms = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--minutes") && hasValue) {
+      opt.minutes = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--period") && hasValue) {
+      opt.periodMs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--broker") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.brokerHost, opt.brokerPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--seconds") && hasValue) {
+      opt.seconds = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--dashboards") && hasValue) {
+      opt.dashboards = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--diff")) {
+      opt.diffs = true;
+    } else if (!strcmp(argv[i], "--snapshots")) {
+      opt.diffs = false;
+    } else {
+      return false;
+    }
+  }
+  return opt.rooms > 0 && opt.minutes > 0 && opt.periodMs >= 0 &&
+         opt.seconds > 0 && opt.dashboards > 0;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    fprintf(stderr,
+            "usage: %s [--rooms N] [--minutes M] [--period MS] "
+            "[--broker HOST:PORT] [--seconds S] [--dashboards D] "
+            "[--diff|--snapshots]\n",
+            argv[0]);
+    return 2;
+  }
+
+  printf("== offline: %d rooms in %d buildings, %.0f min, period %d ms ==\n",
+         opt.rooms, (opt.rooms + ROOMS_PER_BUILDING - 1) / ROOMS_PER_BUILDING,
+         opt.minutes, opt.periodMs);
+  printf("%-22s %10s %10s %10s %10s %10s\n", "per dashboard", "msg/s",
+         "KiB/s", "ns/msg in", "stale p50", "stale max");
+  std::vector<std::string> topics =
+      CampusTraffic::topics(opt.rooms, ROOMS_PER_BUILDING);
+  runOffline(opt, false, topics, true);
+  runOffline(opt, true, topics, false);
+
+  if (!opt.brokerHost.empty() && !runOnline(opt)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,816 @@
+/*
+        Smart Campus fleet load generator
+
+        Simulates N nodes, each with its own MQTT connection,
+        publishing the topics and payload formats of main.cpp:
+
+          esp32/status     "ESP32 Connected" after every connect
+          Door             "Open" / "Closed"
+          Lx               "%u"
+          Humidity, Temperature, FeltTemperature   "%.2f"
+          Motion           "none" / "stationary" / "moving"
+          Occupancy        "%u"
+
+        Every node runs a classroom model (lectures with arrivals
+        and departures through the door, lights, daylight, the
+        room warming up while occupied) and, by default, the
+        firmware's schedule: AdaptiveSampler for light and
+        climate, door and presence edges published at once.
+        --interval switches to a fixed publish cycle instead, and
+        --speed runs the simulated clock faster than real time so
+        a whole day of activity fits in a short test.
+
+        Nodes publish under --prefix, a printf format. With two
+        integer conversions it takes the building and the room
+        (default sim/bldg-%02d/room-%03d/, --rooms-per-building
+        rooms each), which is how the ingest daemon and the bridge
+        split topics; with one it takes the node number. An empty
+        prefix publishes the bare firmware topics, like a fleet of
+        identical boards.
+        A subscriber on the same broker matches each delivery to
+        its publish, by topic and payload in publish order, to
+        measure publish-to-subscribe latency. Without a number in
+        the prefix deliveries cannot be matched and only
+        throughput is reported. The subscriber is a single thread,
+        so its CPU use is reported too: near 100% the latency
+        includes its own backlog, not just the broker's.
+
+        Connect storms: all nodes connect at once at start-up
+        (spread over --ramp seconds if given), and every --storm
+        seconds a --storm-fraction of them drop their connection
+        and reconnect immediately. Connections are opened by a
+        pool of --connectors threads, so nodes waiting for a
+        CONNACK do not hold up the publishes of the others.
+        CONNACK times are reported. Connections the broker closes
+        or resets are counted per second and reconnected, so an
+        overloaded broker shows up as disconnects rather than
+        ending the run.
+
+        Runs against the docker-compose broker or any local
+        mosquitto:
+          docker compose up mosquitto      (or: mosquitto -p 1883)
+          fleet_loadgen --nodes 500 --speed 60 --duration 60
+
+        Usage:
+          fleet_loadgen [--broker HOST:PORT] [--nodes N] [--threads T]
+                        [--connectors C] [--duration S] [--interval MS]
+                        [--speed X] [--prefix P] [--rooms-per-building R]
+                        [--ramp S] [--storm S] [--storm-fraction F]
+*/
+
+#include "../../include/AdaptiveSampler.hpp"
+#include "../../include/SamplingConfig.hpp"
+#include "MqttClient.hpp"
+#include "Xorshift.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Real time between two passes of a publisher thread over its nodes
+#define TICK_MS 10
+
+// Publishes remembered per node and topic for latency matching
+#define PENDING_PER_TOPIC 64
+
+// Delay before a node whose connect failed is queued again
+#define CONNECT_RETRY_MS 100
+
+// Default connector threads; more than this only adds contention
+#define MAX_CONNECTORS 64
+
+// Subscriber CPU use above which latencies are its own, not the broker's
+#define SUBSCRIBER_BUSY 0.9
+
+/*
+        A node's connection is handed between its publisher
+        thread and the connector threads: only the thread the
+        state points to touches the client.
+*/
+enum NodeState {
+  NODE_DISCONNECTED, // publisher queues it for a connector
+  NODE_CONNECTING,   // queued or being connected
+  NODE_CONNECTED     // publisher runs it
+};
+
+enum Topic {
+  T_STATUS,
+  T_DOOR,
+  T_LUX,
+  T_HUMIDITY,
+  T_TEMPERATURE,
+  T_FELT,
+  T_MOTION,
+  T_OCCUPANCY,
+  TOPICS
+};
+
+static const char *topicNames[TOPICS] = {
+    "esp32/status", "Door",            "Lx",     "Humidity",
+    "Temperature",  "FeltTemperature", "Motion", "Occupancy"};
+
+struct Options {
+  std::string brokerHost = "127.0.0.1";
+  uint16_t brokerPort = 1883;
+  int nodes = 100;
+  int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+  int connectors = 0;
+  double duration = 30;
+  int interval = 0;
+  double speed = 1;
+  std::string prefix = "sim/bldg-%02d/room-%03d/";
+  int roomsPerBuilding = 50;
+  double ramp = 0;
+  double storm = 0;
+  double stormFraction = 1;
+};
+
+struct Pending {
+  int64_t sentNs;
+  uint8_t len;
+  char payload[23];
+};
+
+// Publishes not yet delivered to the subscriber, oldest first
+struct PendingRing {
+  Pending slot[PENDING_PER_TOPIC];
+  uint32_t head = 0;
+  uint32_t tail = 0;
+};
+
+struct Node {
+  int index;
+  MqttClient client;
+  std::string topics[TOPICS];
+  std::atomic<int> state{NODE_DISCONNECTED};
+  bool dropRequested = false;
+  int64_t nextPoll = 0;
+
+  // Classroom model, deterministic per node
+  Xorshift rng;
+  int64_t lectureOffset; // ms into each 2 h period where a lecture starts
+  int lectureMask;       // which of the day's periods have a lecture
+  float temperature = 20;
+  float humidity = 45;
+  int64_t lastModel = -1;
+
+  // Firmware state
+  AdaptiveSampler lux{LUX_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                      LUX_THRESHOLD};
+  AdaptiveSampler climate{CLIMATE_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                          CLIMATE_THRESHOLD};
+  float readHumidity = 45;
+  bool lastDoor = false;
+  int lastMotion = 0;
+  int lastOccupancy = 0;
+  int64_t nextFixed = 0;
+
+  std::mutex lock;
+  PendingRing pending[TOPICS];
+};
+
+struct Shared {
+  Options opt;
+  std::string filter;
+  std::vector<Node *> nodes;
+  std::unordered_map<std::string, std::pair<int, int>> topicIndex;
+  bool matchLatency;
+  int64_t startNs;
+  std::atomic<bool> stop{false};
+
+  std::atomic<uint64_t> sent{0};
+  std::atomic<uint64_t> received{0};
+  std::atomic<uint64_t> lost{0};
+  std::atomic<uint64_t> unmatched{0};
+  std::atomic<uint64_t> reconnects{0};
+  std::atomic<uint64_t> brokerDrops{0};
+  std::atomic<uint64_t> subscriberDrops{0};
+  std::atomic<uint64_t> connectFailures{0};
+  std::atomic<int> connectedNodes{0};
+  std::atomic<uint64_t> stormGeneration{0};
+  std::atomic<int64_t> subscriberCpuNs{0};
+
+  // Nodes waiting for a connector thread
+  std::mutex connectLock;
+  std::condition_variable connectReady;
+  std::deque<Node *> connectQueue;
+
+  std::mutex statsLock;
+  std::vector<float> latencyUs;
+  std::vector<float> connectMs;
+};
+
+struct RoomState {
+  bool door;
+  bool occupied;
+  int people;
+  bool moving;
+  float lux;
+};
+
+/*
+        Room at simulated time t (ms since midnight). Each 2 h
+        period may hold a 90 min lecture; people arrive through
+        the door in the first 5 minutes and leave in the last 3,
+        the light is on while anyone is there, and daylight
+        follows the sun between 07:00 and 19:00.
+*/
+static RoomState roomAt(Node &n, int64_t t) {
+  const int64_t period = 2 * 3600000LL;
+  int64_t inPeriod = ((t - n.lectureOffset) % period + period) % period;
+  int slot = (int)(((t - n.lectureOffset) / period) % 12);
+  bool lecture = (n.lectureMask >> slot) & 1;
+
+  RoomState s{};
+  int64_t end = 90 * 60000LL;
+  s.occupied = lecture && inPeriod < end + 180000;
+  bool arriving = inPeriod < 300000;
+  bool leaving = inPeriod >= end && inPeriod < end + 180000;
+  s.door = lecture && ((arriving && (inPeriod / 1000) % 41 < 13) ||
+                       (leaving && (inPeriod / 1000) % 31 < 14));
+  s.people = s.occupied ? 1 + (int)((n.index + slot) % 4) : 0;
+  s.moving = s.occupied && (arriving || leaving || (inPeriod / 20000) % 9 == 0);
+
+  float h = (float)(t % (24 * 3600000LL)) / 3600000.0f;
+  float daylight =
+      h > 7 && h < 19 ? 150.0f * sinf(3.14159f * (h - 7) / 12) : 0.0f;
+  s.lux = 2.0f + daylight + (s.occupied ? 450.0f : 0.0f) +
+          3.0f * (n.rng.uniform() * 2 - 1);
+  return s;
+}
+
+// Climate drifts towards occupied/empty targets; DHT11 reports integers
+static void updateClimate(Node &n, int64_t t, bool occupied) {
+  if (n.lastModel >= 0) {
+    float dtHours = (float)(t - n.lastModel) / 3600000.0f;
+    n.temperature += ((occupied ? 25.0f : 19.0f) - n.temperature) *
+                     std::min(1.0f, 0.2f * dtHours);
+    n.humidity += ((occupied ? 60.0f : 45.0f) - n.humidity) *
+                  std::min(1.0f, 0.4f * dtHours);
+  }
+  n.lastModel = t;
+}
+
+// Steadman's approximation, which the DHT library uses in this range
+static float heatIndex(float celsius, float humidity) {
+  float f = celsius * 1.8f + 32;
+  float hi = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + humidity * 0.094f);
+  return (hi - 32) / 1.8f;
+}
+
+// The broker closed or reset the node's connection; it reconnects next pass
+static void connectionLost(Shared &sh, Node &n) {
+  if (n.state == NODE_CONNECTED) {
+    n.state = NODE_DISCONNECTED;
+    sh.connectedNodes--;
+    sh.brokerDrops++;
+  }
+}
+
+static void publish(Shared &sh, Node &n, int topic, const char *payload) {
+  size_t len = strlen(payload);
+  if (sh.matchLatency && len < sizeof(Pending::payload)) {
+    std::lock_guard<std::mutex> guard(n.lock);
+    PendingRing &ring = n.pending[topic];
+    if (ring.tail - ring.head == PENDING_PER_TOPIC) {
+      ring.head++; // Never delivered in time
+      sh.lost++;
+    }
+    Pending &p = ring.slot[ring.tail++ % PENDING_PER_TOPIC];
+    p.sentNs = monotonicNs();
+    p.len = (uint8_t)len;
+    memcpy(p.payload, payload, len);
+  }
+  if (n.client.publish(n.topics[topic], payload)) {
+    sh.sent++;
+  } else {
+    connectionLost(sh, n);
+  }
+}
+
+// Runs on a connector thread while the node is NODE_CONNECTING
+static void connectNode(Shared &sh, Node &n, std::vector<float> &connectMs) {
+  char id[32];
+  snprintf(id, sizeof(id), "sim-%d-%d", (int)getpid(), n.index);
+  int64_t t0 = monotonicNs();
+  bool ok = n.client.connect(sh.opt.brokerHost, sh.opt.brokerPort, id);
+  if (ok) {
+    connectMs.push_back((float)((monotonicNs() - t0) / 1e6));
+    publish(sh, n, T_STATUS, "ESP32 Connected");
+    ok = n.client.connected();
+  }
+  if (!ok) {
+    sh.connectFailures++;
+    n.nextPoll = monotonicNs() + CONNECT_RETRY_MS * 1000000LL;
+    n.state = NODE_DISCONNECTED;
+    return;
+  }
+  n.nextPoll = 0;
+  sh.connectedNodes++;
+  n.state = NODE_CONNECTED;
+}
+
+static void connectorThread(Shared &sh) {
+  std::vector<float> connectMs;
+  for (;;) {
+    Node *n;
+    {
+      std::unique_lock<std::mutex> guard(sh.connectLock);
+      sh.connectReady.wait(
+          guard, [&] { return sh.stop || !sh.connectQueue.empty(); });
+      if (sh.stop) {
+        break;
+      }
+      n = sh.connectQueue.front();
+      sh.connectQueue.pop_front();
+    }
+    connectNode(sh, *n, connectMs);
+  }
+  std::lock_guard<std::mutex> guard(sh.statsLock);
+  sh.connectMs.insert(sh.connectMs.end(), connectMs.begin(), connectMs.end());
+}
+
+static void queueConnect(Shared &sh, Node &n) {
+  n.state = NODE_CONNECTING;
+  {
+    std::lock_guard<std::mutex> guard(sh.connectLock);
+    sh.connectQueue.push_back(&n);
+  }
+  sh.connectReady.notify_one();
+}
+
+/*
+        One pass of main.cpp's loop() for a node at simulated
+        time t (ms since midnight).
+*/
+static void runNode(Shared &sh, Node &n, int64_t t) {
+  static const char *motionText[] = {"none", "stationary", "moving"};
+  char buf[32];
+  RoomState room = roomAt(n, t);
+  updateClimate(n, t, room.occupied);
+  uint32_t now = (uint32_t)t;
+
+  if (sh.opt.interval > 0) {
+    // Previous firmware: everything every publishInterval
+    if (t < n.nextFixed) {
+      return;
+    }
+    n.nextFixed = t + sh.opt.interval;
+    publish(sh, n, T_DOOR, room.door ? "Open" : "Closed");
+    snprintf(buf, sizeof(buf), "%u", (unsigned)std::max(0.0f, room.lux));
+    publish(sh, n, T_LUX, buf);
+    snprintf(buf, sizeof(buf), "%.2f", roundf(n.humidity));
+    publish(sh, n, T_HUMIDITY, buf);
+    snprintf(buf, sizeof(buf), "%.2f", roundf(n.temperature));
+    publish(sh, n, T_TEMPERATURE, buf);
+    snprintf(buf, sizeof(buf), "%.2f",
+             heatIndex(roundf(n.temperature), roundf(n.humidity)));
+    publish(sh, n, T_FELT, buf);
+    return;
+  }
+
+  bool doorChanged = room.door != n.lastDoor;
+  n.lastDoor = room.door;
+  int motion = room.moving ? 2 : room.occupied ? 1 : 0;
+  bool motionChanged = motion != n.lastMotion;
+  bool presenceChanged = (motion != 0) != (n.lastMotion != 0);
+  n.lastMotion = motion;
+  bool occupancyChanged = room.people != n.lastOccupancy;
+  n.lastOccupancy = room.people;
+
+  if (doorChanged || presenceChanged) {
+    n.lux.boost(now);
+    n.climate.boost(now);
+  }
+  bool luxDue = n.lux.due(now);
+  bool climateDue = n.climate.due(now);
+
+  if (doorChanged || luxDue) {
+    publish(sh, n, T_DOOR, room.door ? "Open" : "Closed");
+  }
+  if (motionChanged) {
+    publish(sh, n, T_MOTION, motionText[motion]);
+  }
+  if (occupancyChanged) {
+    snprintf(buf, sizeof(buf), "%u", (unsigned)room.people);
+    publish(sh, n, T_OCCUPANCY, buf);
+  }
+  if (luxDue) {
+    uint16_t lux = (uint16_t)std::max(0.0f, room.lux);
+    n.lux.record(lux, now);
+    snprintf(buf, sizeof(buf), "%u", lux);
+    publish(sh, n, T_LUX, buf);
+  }
+  if (climateDue) {
+    float temperature = roundf(n.temperature);
+    float humidity = roundf(n.humidity);
+    n.climate.record(temperature, now);
+    if (fabsf(humidity - n.readHumidity) >= HUMIDITY_ACTIVITY) {
+      n.climate.boost(now);
+    }
+    n.readHumidity = humidity;
+    snprintf(buf, sizeof(buf), "%.2f", humidity);
+    publish(sh, n, T_HUMIDITY, buf);
+    snprintf(buf, sizeof(buf), "%.2f", temperature);
+    publish(sh, n, T_TEMPERATURE, buf);
+    snprintf(buf, sizeof(buf), "%.2f", heatIndex(temperature, humidity));
+    publish(sh, n, T_FELT, buf);
+  }
+}
+
+static void publisherThread(Shared &sh, int first, int count) {
+  const Options &opt = sh.opt;
+  uint64_t seenStorm = 0;
+
+  while (!sh.stop) {
+    int64_t nowNs = monotonicNs();
+    double elapsed = (nowNs - sh.startNs) / 1e9;
+    // Simulated clock: 08:00 on the first day plus accelerated time
+    int64_t simMs = 8 * 3600000LL + (int64_t)(elapsed * opt.speed * 1000);
+
+    uint64_t storm = sh.stormGeneration;
+    if (storm != seenStorm) {
+      seenStorm = storm;
+      for (int i = first; i < first + count; i++) {
+        Node &n = *sh.nodes[i];
+        n.dropRequested =
+            n.state == NODE_CONNECTED && n.rng.uniform() < opt.stormFraction;
+      }
+    }
+
+    for (int i = first; i < first + count && !sh.stop; i++) {
+      Node &n = *sh.nodes[i];
+      int state = n.state;
+      if (n.dropRequested && state == NODE_CONNECTED) {
+        n.client.disconnect();
+        n.state = state = NODE_DISCONNECTED;
+        sh.connectedNodes--;
+        sh.reconnects++;
+      }
+      n.dropRequested = false;
+      if (state == NODE_DISCONNECTED) {
+        // With --ramp, node i may only connect after i/N of the ramp
+        if (elapsed >= opt.ramp * i / opt.nodes && nowNs >= n.nextPoll) {
+          queueConnect(sh, n);
+        }
+        continue;
+      }
+      if (state != NODE_CONNECTED) {
+        continue;
+      }
+      runNode(sh, n, simMs);
+      if (n.state != NODE_CONNECTED) {
+        continue;
+      }
+      if (nowNs >= n.nextPoll) {
+        // Answers PINGRESP and notices a broker-side disconnect
+        if (!n.client.poll(0, nullptr)) {
+          connectionLost(sh, n);
+        }
+        n.nextPoll = nowNs + 1000000000LL;
+      }
+    }
+
+    int64_t left = TICK_MS * 1000000LL - (monotonicNs() - nowNs);
+    if (left > 0) {
+      usleep((useconds_t)(left / 1000));
+    }
+  }
+}
+
+static int64_t threadCpuNs() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void subscriberThread(Shared &sh, MqttClient &sub) {
+  std::string key;
+  std::vector<float> batch;
+
+  MqttClient::MessageHandler onMessage = [&](const char *topic, size_t topicLen,
+                                             const uint8_t *payload,
+                                             size_t len) {
+    int64_t now = monotonicNs();
+    sh.received++;
+    if (!sh.matchLatency) {
+      return;
+    }
+    key.assign(topic, topicLen);
+    auto it = sh.topicIndex.find(key);
+    if (it == sh.topicIndex.end()) {
+      sh.unmatched++;
+      return;
+    }
+    Node &n = *sh.nodes[it->second.first];
+    std::lock_guard<std::mutex> guard(n.lock);
+    PendingRing &ring = n.pending[it->second.second];
+    // Broker keeps per-topic order; skip publishes it dropped
+    while (ring.head != ring.tail) {
+      Pending &p = ring.slot[ring.head++ % PENDING_PER_TOPIC];
+      if (p.len == len && memcmp(p.payload, payload, len) == 0) {
+        batch.push_back((float)((now - p.sentNs) / 1000.0));
+        return;
+      }
+      sh.lost++;
+    }
+    sh.unmatched++;
+  };
+
+  while (!sh.stop) {
+    if (!sub.poll(50, onMessage)) {
+      // Deliveries in flight are gone; their publishes count as lost
+      sh.subscriberDrops++;
+      while (!sh.stop &&
+             !(sub.connect(sh.opt.brokerHost, sh.opt.brokerPort,
+                           "sim-subscriber-" + std::to_string(getpid())) &&
+               sub.subscribe(sh.filter))) {
+        sub.disconnect();
+        usleep(100000);
+      }
+    }
+    sh.subscriberCpuNs = threadCpuNs();
+    if (!batch.empty()) {
+      std::lock_guard<std::mutex> guard(sh.statsLock);
+      sh.latencyUs.insert(sh.latencyUs.end(), batch.begin(), batch.end());
+      batch.clear();
+    }
+  }
+}
+
+static float percentile(std::vector<float> &v, size_t from, double p) {
+  if (v.size() <= from) {
+    return 0;
+  }
+  size_t k = from + (size_t)(p * (v.size() - from - 1));
+  std::nth_element(v.begin() + from, v.begin() + k, v.end());
+  return v[k];
+}
+
+/*
+        --prefix is used as a printf format with the node number,
+        or the building and room numbers, as arguments, so it may
+        hold at most two integer conversions (%d or %i, with flags
+        and width) besides %%. Sets numbers to how many it holds.
+*/
+static bool validPrefix(const std::string &prefix, int &numbers) {
+  numbers = 0;
+  for (size_t i = 0; i < prefix.size(); i++) {
+    if (prefix[i] != '%') {
+      continue;
+    }
+    i++;
+    if (i < prefix.size() && prefix[i] == '%') {
+      continue;
+    }
+    while (i < prefix.size() && strchr("-+ 0#123456789", prefix[i])) {
+      i++;
+    }
+    if (i == prefix.size() || !strchr("di", prefix[i]) || numbers == 2) {
+      return false;
+    }
+    numbers++;
+  }
+  return true;
+}
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--broker") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.brokerHost, opt.brokerPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--nodes") && hasValue) {
+      opt.nodes = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--threads") && hasValue) {
+      opt.threads = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--connectors") && hasValue) {
+      opt.connectors = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--duration") && hasValue) {
+      opt.duration = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--interval") && hasValue) {
+      opt.interval = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--speed") && hasValue) {
+      opt.speed = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--prefix") && hasValue) {
+      opt.prefix = argv[++i];
+    } else if (!strcmp(argv[i], "--rooms-per-building") && hasValue) {
+      opt.roomsPerBuilding = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--ramp") && hasValue) {
+      opt.ramp = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--storm") && hasValue) {
+      opt.storm = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--storm-fraction") && hasValue) {
+      opt.stormFraction = atof(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  opt.threads = std::min(opt.threads, opt.nodes);
+  if (opt.connectors == 0) {
+    opt.connectors = std::min(opt.nodes, MAX_CONNECTORS);
+  }
+  int numbers;
+  if (!validPrefix(opt.prefix, numbers)) {
+    fprintf(stderr, "--prefix takes a %%d for the node number, or two for "
+                    "the building and room\n");
+    return false;
+  }
+  return opt.nodes > 0 && opt.threads > 0 && opt.connectors > 0 &&
+         opt.duration > 0 && opt.speed > 0 && opt.interval >= 0 &&
+         opt.roomsPerBuilding > 0;
+}
+
+// One socket per node plus the subscriber
+static void raiseFileLimit(int nodes) {
+  rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)nodes + 64) {
+    rl.rlim_cur = std::min(rl.rlim_max, (rlim_t)nodes + 64);
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < (rlim_t)nodes + 64) {
+      fprintf(stderr, "warning: only %llu file descriptors for %d nodes\n",
+              (unsigned long long)rl.rlim_cur, nodes);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  Shared sh;
+  if (!parseArgs(argc, argv, sh.opt)) {
+    fprintf(stderr,
+            "usage: %s [--broker HOST:PORT] [--nodes N] [--threads T] "
+            "[--connectors C] [--duration S] [--interval MS] [--speed X] "
+            "[--prefix P] [--rooms-per-building R] [--ramp S] [--storm S] "
+            "[--storm-fraction F]\n",
+            argv[0]);
+    return 2;
+  }
+  const Options &opt = sh.opt;
+  raiseFileLimit(opt.nodes);
+
+  // Without a per-node number in the prefix, deliveries are ambiguous
+  int numbers;
+  validPrefix(opt.prefix, numbers);
+  sh.matchLatency = numbers > 0;
+  for (int i = 0; i < opt.nodes; i++) {
+    Node *n = new Node;
+    n->index = i;
+    n->rng = Xorshift(2463534242u + 7919u * (uint32_t)i);
+    n->rng.next();
+    n->lectureOffset = (int64_t)(n->rng.uniform() * 30 * 60000);
+    n->lectureMask = (int)(n->rng.next() & 0xFFF) | 0x10; // 08:00 too
+    char prefix[128];
+    if (numbers == 2) {
+      snprintf(prefix, sizeof(prefix), opt.prefix.c_str(),
+               i / opt.roomsPerBuilding, i % opt.roomsPerBuilding);
+    } else {
+      snprintf(prefix, sizeof(prefix), opt.prefix.c_str(), i);
+    }
+    for (int t = 0; t < TOPICS; t++) {
+      n->topics[t] = std::string(prefix) + topicNames[t];
+      sh.topicIndex[n->topics[t]] = {i, t};
+    }
+    sh.nodes.push_back(n);
+  }
+
+  MqttClient sub;
+  // Everything below the fixed part of the prefix, e.g. sim/#
+  std::string fixed = opt.prefix.substr(0, opt.prefix.find('%'));
+  sh.filter = sh.matchLatency
+                  ? fixed.substr(0, fixed.rfind('/') + 1) + "#"
+                  : "#";
+  if (!sub.connect(opt.brokerHost, opt.brokerPort,
+                   "sim-subscriber-" + std::to_string(getpid())) ||
+      !sub.subscribe(sh.filter)) {
+    fprintf(stderr, "cannot subscribe to %s on %s:%u\n", sh.filter.c_str(),
+            opt.brokerHost.c_str(), opt.brokerPort);
+    return 1;
+  }
+
+  printf("== %d nodes, %d threads, %d connectors, %s, speed x%.0f, %.0f s "
+         "against %s:%u ==\n",
+         opt.nodes, opt.threads, opt.connectors,
+         opt.interval ? "fixed interval" : "firmware schedule", opt.speed,
+         opt.duration, opt.brokerHost.c_str(), opt.brokerPort);
+  printf("%6s %9s %9s %9s %9s %9s %9s %9s\n", "time", "connected", "dropped",
+         "sent/s", "recv/s", "p50 ms", "p99 ms", "sub cpu%");
+
+  sh.startNs = monotonicNs();
+  std::thread subscriber(subscriberThread, std::ref(sh), std::ref(sub));
+  std::vector<std::thread> connectors;
+  for (int t = 0; t < opt.connectors; t++) {
+    connectors.emplace_back(connectorThread, std::ref(sh));
+  }
+  std::vector<std::thread> publishers;
+  for (int t = 0; t < opt.threads; t++) {
+    int first = opt.nodes * t / opt.threads;
+    int last = opt.nodes * (t + 1) / opt.threads;
+    publishers.emplace_back(publisherThread, std::ref(sh), first,
+                            last - first);
+  }
+
+  uint64_t lastSent = 0, lastReceived = 0, lastDrops = 0;
+  size_t lastLatency = 0;
+  int64_t lastCpu = 0, lastCpuAt = sh.startNs;
+  double subscriberMax = 0;
+  double nextStorm = opt.storm;
+  for (int s = 1; s <= (int)ceil(opt.duration); s++) {
+    sleep(1);
+    if (opt.storm > 0 && s >= nextStorm) {
+      sh.stormGeneration++;
+      nextStorm += opt.storm;
+    }
+    uint64_t sent = sh.sent, received = sh.received;
+    float p50, p99;
+    {
+      std::lock_guard<std::mutex> guard(sh.statsLock);
+      p50 = percentile(sh.latencyUs, lastLatency, 0.50) / 1000;
+      p99 = percentile(sh.latencyUs, lastLatency, 0.99) / 1000;
+      lastLatency = sh.latencyUs.size();
+    }
+    uint64_t drops = sh.brokerDrops;
+    int64_t cpu = sh.subscriberCpuNs, cpuAt = monotonicNs();
+    double busy = (double)(cpu - lastCpu) / (cpuAt - lastCpuAt);
+    subscriberMax = std::max(subscriberMax, busy);
+    printf("%5ds %9d %9llu %9llu %9llu %9.2f %9.2f %9.0f\n", s,
+           sh.connectedNodes.load(), (unsigned long long)(drops - lastDrops),
+           (unsigned long long)(sent - lastSent),
+           (unsigned long long)(received - lastReceived), p50, p99,
+           busy * 100);
+    fflush(stdout);
+    lastSent = sent;
+    lastReceived = received;
+    lastDrops = drops;
+    lastCpu = cpu;
+    lastCpuAt = cpuAt;
+  }
+
+  sh.stop = true;
+  {
+    std::lock_guard<std::mutex> guard(sh.connectLock);
+    sh.connectReady.notify_all();
+  }
+  for (std::thread &t : connectors) {
+    t.join();
+  }
+  for (std::thread &t : publishers) {
+    t.join();
+  }
+  subscriber.join();
+  sub.disconnect();
+  for (Node *n : sh.nodes) {
+    n->client.disconnect();
+  }
+
+  double seconds = (monotonicNs() - sh.startNs) / 1e9;
+  std::vector<float> &lat = sh.latencyUs;
+  std::vector<float> &con = sh.connectMs;
+  printf("\nsent %llu (%.0f msg/s), received %llu (%.0f msg/s), "
+         "lost %llu, unmatched %llu\n",
+         (unsigned long long)sh.sent.load(), sh.sent / seconds,
+         (unsigned long long)sh.received.load(), sh.received / seconds,
+         (unsigned long long)sh.lost.load(),
+         (unsigned long long)sh.unmatched.load());
+  if (sh.matchLatency) {
+    printf("latency ms   p50 %.2f  p90 %.2f  p99 %.2f  p99.9 %.2f  max %.2f "
+           "(%zu samples)\n",
+           percentile(lat, 0, 0.5) / 1000, percentile(lat, 0, 0.9) / 1000,
+           percentile(lat, 0, 0.99) / 1000, percentile(lat, 0, 0.999) / 1000,
+           percentile(lat, 0, 1.0) / 1000, lat.size());
+  }
+  printf("connect ms   p50 %.2f  p99 %.2f  max %.2f  (%zu connects, %llu "
+         "storm drops, %llu failures)\n",
+         percentile(con, 0, 0.5), percentile(con, 0, 0.99),
+         percentile(con, 0, 1.0), con.size(),
+         (unsigned long long)sh.reconnects.load(),
+         (unsigned long long)sh.connectFailures.load());
+  printf("disconnects  %llu node connections and %llu subscriber "
+         "connections closed by the broker\n",
+         (unsigned long long)sh.brokerDrops.load(),
+         (unsigned long long)sh.subscriberDrops.load());
+  printf("subscriber   %.0f%% of a core on average, %.0f%% at most\n",
+         100.0 * sh.subscriberCpuNs / (seconds * 1e9), subscriberMax * 100);
+  if (subscriberMax > SUBSCRIBER_BUSY) {
+    printf("warning: the subscriber thread was saturated; latencies above "
+           "include its backlog, not just the broker's\n");
+  }
+
+  for (Node *n : sh.nodes) {
+    delete n;
+  }
+  return 0;
+}
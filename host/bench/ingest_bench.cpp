@@ -0,0 +1,225 @@
+/*
+        Ingest daemon throughput and storage cost
+
+        Simulates a campus of N nodes publishing what main.cpp
+        publishes at adaptive-sampling rates (CampusTraffic), on
+        per-node topics such as bldg-3/room-042/Lx, over a span
+        of virtual time. Every message goes through the same
+        Ingestor::handle() path as campus_ingest, into a store in
+        a scratch directory, and rollups run once per virtual
+        second as they do in the daemon.
+
+        Reports ingest samples/s on one core, bytes/sample for
+        the encoded columns, the rollup records and the allocated
+        blocks, rollup cost, and raw/rollup query speed from a
+        second, read-only mapping of the store (as campus_query
+        does). The raw samples of one node are checked against
+        what was sent.
+
+        Without --data the store goes to a scratch directory
+        under /tmp that is removed on exit unless --keep is
+        given.
+
+        Usage:
+          ingest_bench [--nodes N] [--hours H] [--data DIR] [--keep]
+*/
+
+#include "CampusTraffic.hpp"
+#include "Ingestor.hpp"
+#include "MqttClient.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// 2026-10-19 06:00 UTC, so rollups land on real minute and hour edges
+#define START_MS 1792389600000LL
+
+#define ROOMS_PER_BUILDING 200
+
+
+// Removes the scratch store when main() returns, after the store is closed
+struct ScratchDir {
+  std::string path;
+  ~ScratchDir() {
+    if (!path.empty()) {
+      std::error_code ec;
+      std::filesystem::remove_all(path, ec);
+    }
+  }
+};
+
+int main(int argc, char **argv) {
+  int nodeCount = 5000;
+  double hours = 2;
+  std::string dir;
+  bool keep = false;
+  ScratchDir scratch;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--nodes") && hasValue) {
+      nodeCount = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--hours") && hasValue) {
+      hours = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--data") && hasValue) {
+      dir = argv[++i];
+    } else if (!strcmp(argv[i], "--keep")) {
+      keep = true;
+    } else {
+      fprintf(stderr,
+              "usage: %s [--nodes N] [--hours H] [--data DIR] [--keep]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (nodeCount <= 0 || hours <= 0) {
+    return 2;
+  }
+  if (dir.empty()) {
+    char tmpl[] = "/tmp/ingest_bench.XXXXXX";
+    if (!mkdtemp(tmpl)) {
+      perror("mkdtemp");
+      return 1;
+    }
+    dir = tmpl;
+    if (!keep) {
+      scratch.path = dir;
+    }
+  }
+
+  std::vector<std::string> topics =
+      CampusTraffic::topics(nodeCount, ROOMS_PER_BUILDING);
+  CampusTraffic traffic(nodeCount, START_MS);
+
+  TimeSeriesStore store;
+  if (!store.open(dir)) {
+    return 1;
+  }
+  Ingestor ingest(store);
+
+  // Node 0's Temperature as sent, to check what comes back
+  std::vector<std::pair<int64_t, float>> expected;
+
+  std::vector<TrafficMessage> batch;
+  int64_t end = START_MS + (int64_t)(hours * 3600000);
+  int64_t ingestNs = 0, rollupNs = 0;
+  size_t rollups = 0;
+  for (int64_t t = START_MS; t < end; t += 1000) {
+    traffic.generate(t, batch);
+
+    int64_t t0 = monotonicNs();
+    for (const TrafficMessage &m : batch) {
+      const std::string &topic = topics[m.topic];
+      ingest.handle(topic.data(), topic.size(),
+                    reinterpret_cast<const uint8_t *>(m.payload), m.len,
+                    m.time);
+    }
+    int64_t t1 = monotonicNs();
+    rollups += store.rollup(t + 1000);
+    rollupNs += monotonicNs() - t1;
+    ingestNs += t1 - t0;
+
+    for (const TrafficMessage &m : batch) {
+      if (m.topic == TRAFFIC_TEMPERATURE) {
+        expected.emplace_back(m.time, (float)atof(m.payload));
+      }
+    }
+  }
+
+  uint64_t samples = store.samplesAppended();
+  double perSample = (double)store.bytesAppended() / samples;
+  double rollupBytes = (double)rollups * sizeof(Rollup) / samples;
+  double allocatedBytes = (double)store.blocksAllocated() * TSDB_BLOCK_BYTES;
+  printf("== ingest: %d nodes, %.1f h, %zu series, %llu samples "
+         "(%.0f/s simulated) ==\n",
+         nodeCount, hours, store.seriesCount(), (unsigned long long)samples,
+         samples / (hours * 3600));
+  printf("ingest       %10.0f samples/s on one core (%.0f ns/sample)\n",
+         samples / (ingestNs / 1e9), (double)ingestNs / samples);
+  // Every series has a partly filled tail block per level; they dominate
+  // the allocated size of short runs
+  printf("storage      %10.2f bytes/sample encoded raw, %.2f in rollups, "
+         "%.2f allocated\n",
+         perSample, rollupBytes, allocatedBytes / samples);
+  printf("             %10.1f KiB allocated per series (raw, 1 min and 1 h "
+         "blocks)\n",
+         allocatedBytes / store.seriesCount() / 1024);
+  printf("rollups      %10zu records, %.1f ms total, %.2f%% of ingest time\n",
+         rollups, rollupNs / 1e6, 100.0 * rollupNs / ingestNs);
+  printf("ignored      %10llu messages, %llu refused\n",
+         (unsigned long long)ingest.ignored(),
+         (unsigned long long)ingest.refused());
+  store.close();
+
+  // Query side: a separate read-only mapping, like campus_query
+  TimeSeriesStore reader;
+  if (!reader.open(dir, true)) {
+    return 1;
+  }
+  uint64_t read = 0, minuteRecords = 0, rolledSamples = 0;
+  double checksum = 0;
+  int64_t t0 = monotonicNs();
+  for (const std::string &metric : reader.metrics()) {
+    for (const std::string &node : reader.nodes(metric)) {
+      SampleCursor c =
+          reader.samples(reader.series(metric, node), START_MS, end);
+      int64_t t;
+      float v;
+      while (c.next(t, v)) {
+        checksum += v;
+        read++;
+      }
+    }
+  }
+  int64_t rawNs = monotonicNs() - t0;
+
+  t0 = monotonicNs();
+  for (const std::string &metric : reader.metrics()) {
+    for (const std::string &node : reader.nodes(metric)) {
+      reader.rollups(reader.series(metric, node), ROLLUP_MINUTE, START_MS, end,
+                     [&](const Rollup *r, size_t n) {
+                       minuteRecords += n;
+                       for (size_t i = 0; i < n; i++) {
+                         rolledSamples += r[i].count;
+                       }
+                     });
+    }
+  }
+  int64_t rollupQueryNs = monotonicNs() - t0;
+
+  printf("raw query    %10.0f samples/s (%llu samples, checksum %.0f)\n",
+         read / (rawNs / 1e9), (unsigned long long)read, checksum);
+  printf("1 min query  %10.0f records/s (%llu records covering %llu "
+         "samples)\n",
+         minuteRecords / (rollupQueryNs / 1e9),
+         (unsigned long long)minuteRecords, (unsigned long long)rolledSamples);
+
+  // Round trip check on one series
+  size_t mismatches = 0, i = 0;
+  SampleCursor c = reader.samples(
+      reader.series("Temperature", "bldg-0/room-000"), START_MS, end);
+  int64_t t;
+  float v;
+  while (c.next(t, v)) {
+    if (i >= expected.size() || expected[i].first != t ||
+        fabsf(expected[i].second - v) > 0.005f) {
+      mismatches++;
+    }
+    i++;
+  }
+  mismatches += expected.size() > i ? expected.size() - i : 0;
+  printf("round trip   %10s (%zu samples of bldg-0/room-000/Temperature)\n",
+         mismatches ? "FAILED" : "ok", expected.size());
+  if (scratch.path.empty()) {
+    printf("store left in %s\n", dir.c_str());
+  }
+  return mismatches ? 1 : 0;
+}
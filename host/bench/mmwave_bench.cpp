@@ -0,0 +1,357 @@
+/*
+        mmWave report-mode processing on the host
+
+        Without arguments, a synthetic room is simulated: a
+        per-gate background with noise, then a person sitting
+        still, a person walking through the gates and two people
+        seated apart, separated by empty periods. The frames are
+        encoded as the sensor sends them (with some line garbage
+        and a corrupt frame mixed in), parsed and processed, and
+        the detections are scored against the ground truth:
+
+          presence  room occupied or not
+          state     none / stationary / moving, as published
+                    on the Motion topic
+          targets   count published on the Occupancy topic
+
+        The first MMWAVE_SETTLE_FRAMES frames after every change
+        are not scored; the averages and the presence hold need
+        that long to follow.
+
+        The same byte stream is then replayed repeatedly to time
+        parse + process per frame against the sensor's frame
+        period; the bench fails if any frame takes longer than
+        one period.
+
+        --capture replays raw UART bytes recorded from a sensor
+        in report mode (e.g. cat /dev/ttyUSB0 > radar.bin),
+        prints every change in the published state and times the
+        capture the same way.
+
+        Usage:
+          mmwave_bench [--runs N] [--capture FILE]
+*/
+
+#include "../../include/mmWaveProcessing.hpp"
+#include "MqttClient.hpp"
+#include "Xorshift.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// Report frames arrive about every 100 ms
+#define FRAME_PERIOD_MS 100
+
+// Frames skipped by the scoring after every scenario change
+#define MMWAVE_SETTLE_FRAMES 80
+
+static Xorshift rng(88172645u);
+
+static float uniform() { return rng.uniform(); }
+
+// Approximately normal: sum of uniforms
+static float gaussian() {
+  return uniform() + uniform() + uniform() + uniform() - 2.0f;
+}
+
+enum Kind { EMPTY, SEATED, WALKING, TWO_SEATED };
+
+struct Segment {
+  const char *name;
+  Kind kind;
+  int frames;
+};
+
+static const Segment scenario[] = {
+    {"empty", EMPTY, 300},          {"seated", SEATED, 900},
+    {"empty", EMPTY, 400},          {"walking", WALKING, 400},
+    {"empty", EMPTY, 400},          {"two seated", TWO_SEATED, 900},
+    {"walking", WALKING, 300},      {"empty", EMPTY, 400},
+};
+
+struct Truth {
+  bool presence;
+  bool moving;
+  uint8_t targets;
+  int segment;
+  bool scored;
+};
+
+// Energy of a person spread over the gate they are in and its neighbours
+static void addTarget(float *energy, float gate, float strength) {
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    float d = (g - gate) / 0.6f;
+    energy[g] += strength * expf(-d * d);
+  }
+}
+
+static void appendFrame(std::vector<uint8_t> &out, const float *energy,
+                        bool detected, uint16_t distance) {
+  static const uint8_t header[] = {0xF4, 0xF3, 0xF2, 0xF1};
+  static const uint8_t trailer[] = {0xF8, 0xF7, 0xF6, 0xF5};
+  uint16_t len = 3 + MMWAVE_GATES * 2;
+
+  out.insert(out.end(), header, header + 4);
+  out.push_back(len & 0xFF);
+  out.push_back(len >> 8);
+  out.push_back(detected);
+  out.push_back(distance & 0xFF);
+  out.push_back(distance >> 8);
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    uint16_t e = (uint16_t)std::min(std::max(energy[g], 0.0f), 65535.0f);
+    out.push_back(e & 0xFF);
+    out.push_back(e >> 8);
+  }
+  out.insert(out.end(), trailer, trailer + 4);
+}
+
+/*
+        Build the byte stream for the scenario. Background falls
+        off with distance, with a few percent of noise per frame;
+        a seated person adds a steady reflection with a small
+        breathing ripple, a walker a strong reflection that moves
+        back and forth across the gates.
+*/
+static void buildScenario(std::vector<uint8_t> &stream,
+                          std::vector<Truth> &truth) {
+  float background[MMWAVE_GATES];
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    background[g] = 2000.0f * expf(-g / 3.0f) + 200.0f;
+  }
+
+  int frame = 0;
+  int segments = sizeof(scenario) / sizeof(scenario[0]);
+  for (int s = 0; s < segments; s++) {
+    const Segment &seg = scenario[s];
+    for (int i = 0; i < seg.frames; i++, frame++) {
+      float energy[MMWAVE_GATES];
+      for (int g = 0; g < MMWAVE_GATES; g++) {
+        energy[g] = background[g] * (1.0f + 0.03f * gaussian());
+      }
+
+      float t = frame * FRAME_PERIOD_MS / 1000.0f;
+      float breathing = 1.0f + 0.05f * sinf(2 * 3.14159f * t / 4.0f);
+      Truth tr = {false, false, 0, s, i >= MMWAVE_SETTLE_FRAMES};
+      uint16_t distance = 0;
+      switch (seg.kind) {
+      case EMPTY:
+        break;
+      case SEATED:
+        addTarget(energy, 4.0f, 400.0f * breathing);
+        tr = {true, false, 1, s, tr.scored};
+        distance = 280;
+        break;
+      case WALKING: {
+        // 1.2 m/s, turning around at both ends of the room
+        float pos = fmodf(t * 1.7f, 2.0f * 11.0f);
+        float gate = 2.0f + (pos < 11.0f ? pos : 22.0f - pos);
+        addTarget(energy, gate, 3000.0f * (1.0f + 0.3f * gaussian()));
+        tr = {true, true, 1, s, tr.scored};
+        distance = (uint16_t)(gate * 70);
+        break;
+      }
+      case TWO_SEATED:
+        addTarget(energy, 2.0f, 600.0f * breathing);
+        addTarget(energy, 9.0f, 250.0f * breathing);
+        tr = {true, false, 2, s, tr.scored};
+        distance = 140;
+        break;
+      }
+      truth.push_back(tr);
+      appendFrame(stream, energy, tr.presence, distance);
+
+      // Line noise now and then, and one frame with a broken trailer
+      if (frame % 997 == 0) {
+        stream.push_back(0xF4);
+        stream.push_back(0x00);
+      }
+      if (frame == 1234) {
+        appendFrame(stream, energy, false, 0);
+        stream[stream.size() - 1] ^= 0xFF;
+      }
+    }
+  }
+}
+
+static const char *stateName(const MmWaveResult &r) {
+  return r.moving ? "moving" : r.presence ? "stationary" : "none";
+}
+
+static void score(const std::vector<uint8_t> &stream,
+                  const std::vector<Truth> &truth) {
+  MmWaveFrameParser parser;
+  MmWaveProcessor processor;
+  int segments = sizeof(scenario) / sizeof(scenario[0]);
+  std::vector<int> scored(segments), presence(segments), state(segments),
+      targets(segments);
+
+  size_t pos = 0, used, frame = 0;
+  while (pos < stream.size()) {
+    if (!parser.feed(stream.data() + pos, stream.size() - pos, &used)) {
+      break;
+    }
+    pos += used;
+    MmWaveResult r;
+    processor.process(parser.frame(), &r);
+    if (frame >= truth.size()) {
+      break;
+    }
+    const Truth &t = truth[frame++];
+    if (!t.scored || processor.calibrating()) {
+      continue;
+    }
+    scored[t.segment]++;
+    presence[t.segment] += r.presence == t.presence;
+    state[t.segment] += r.presence == t.presence && r.moving == t.moving;
+    targets[t.segment] += r.targets == t.targets;
+  }
+
+  printf("== detection (%zu frames, %u rejected) ==\n", frame,
+         parser.errors());
+  printf("%-12s %7s %9s %9s %9s\n", "scenario", "frames", "presence", "state",
+         "targets");
+  for (int s = 0; s < segments; s++) {
+    double n = scored[s] ? scored[s] : 1;
+    printf("%-12s %7d %8.1f%% %8.1f%% %8.1f%%\n", scenario[s].name, scored[s],
+           100.0 * presence[s] / n, 100.0 * state[s] / n,
+           100.0 * targets[s] / n);
+  }
+  printf("\n");
+}
+
+static bool timing(const std::vector<uint8_t> &stream, int runs) {
+  std::vector<double> ns;
+  size_t frames = 0;
+  uint32_t sink = 0;
+
+  for (int run = 0; run < runs; run++) {
+    MmWaveFrameParser parser;
+    MmWaveProcessor processor;
+    MmWaveResult r;
+    frames = 0;
+    int64_t t0 = monotonicNs();
+    for (uint8_t b : stream) {
+      if (parser.feed(b)) {
+        processor.process(parser.frame(), &r);
+        sink += r.activeGates;
+        frames++;
+      }
+    }
+    if (frames == 0) {
+      printf("== timing: no frames in %zu bytes ==\n", stream.size());
+      return false;
+    }
+    ns.push_back((double)(monotonicNs() - t0) / frames);
+  }
+  std::sort(ns.begin(), ns.end());
+
+  // Slowest single frame, bytes fed since the previous frame included
+  MmWaveFrameParser parser;
+  MmWaveProcessor processor;
+  MmWaveResult r;
+  int64_t worst = 0;
+  int64_t t0 = monotonicNs();
+  for (uint8_t b : stream) {
+    if (parser.feed(b)) {
+      processor.process(parser.frame(), &r);
+      sink += r.activeGates;
+      int64_t t1 = monotonicNs();
+      worst = std::max(worst, t1 - t0);
+      t0 = t1;
+    }
+  }
+
+  double median = ns[ns.size() / 2];
+  int64_t budget = FRAME_PERIOD_MS * 1000000LL;
+  printf("== timing (%d runs x %zu frames, %zu bytes each) ==\n", runs, frames,
+         stream.size());
+  printf("parse + process   min %.0f ns   median %.0f ns   worst %lld ns per "
+         "frame\n",
+         ns[0], median, (long long)worst);
+  printf("frame period      %d ms -> %.5f%% of one core on this host\n",
+         FRAME_PERIOD_MS, 100.0 * median / budget);
+  printf("(checksum %u)\n", sink);
+  if (worst > budget) {
+    printf("FAILED: a frame took longer than the %d ms frame period\n",
+           FRAME_PERIOD_MS);
+    return false;
+  }
+  return true;
+}
+
+static bool loadCapture(const char *path, std::vector<uint8_t> &stream) {
+  FILE *f = fopen(path, "rb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    stream.insert(stream.end(), buf, buf + n);
+  }
+  fclose(f);
+  return true;
+}
+
+static void replay(const std::vector<uint8_t> &stream) {
+  MmWaveFrameParser parser;
+  MmWaveProcessor processor;
+  MmWaveResult last = {};
+  size_t frames = 0;
+  bool calibrated = false;
+
+  for (uint8_t b : stream) {
+    if (!parser.feed(b)) {
+      continue;
+    }
+    MmWaveResult r;
+    processor.process(parser.frame(), &r);
+    frames++;
+    if (processor.calibrating()) {
+      continue;
+    }
+    if (!calibrated || r.presence != last.presence ||
+        r.moving != last.moving || r.targets != last.targets) {
+      printf("%8.1f s  frame %6zu  %-10s targets %u  gates %04x moving %04x\n",
+             frames * FRAME_PERIOD_MS / 1000.0, frames, stateName(r),
+             r.targets, r.activeGates, r.movingGates);
+    }
+    calibrated = true;
+    last = r;
+  }
+  printf("%zu frames, %u rejected\n\n", frames, parser.errors());
+}
+
+int main(int argc, char **argv) {
+  int runs = 50;
+  const char *capture = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--runs") && i + 1 < argc) {
+      runs = std::max(atoi(argv[++i]), 1);
+    } else if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+      capture = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--runs N] [--capture FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<uint8_t> stream;
+  if (capture) {
+    if (!loadCapture(capture, stream)) {
+      return 1;
+    }
+    replay(stream);
+  } else {
+    std::vector<Truth> truth;
+    buildScenario(stream, truth);
+    score(stream, truth);
+  }
+  return timing(stream, runs) ? 0 : 1;
+}
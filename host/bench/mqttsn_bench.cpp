@@ -0,0 +1,321 @@
+/*
+        MQTT-SN vs MQTT/TCP benchmark
+
+        1) Bytes on the wire for the payloads main.cpp actually
+           publishes, with and without IP/transport headers.
+        2) Publish-to-subscribe latency through a local MQTT-SN
+           gateway (UDP) and directly to the broker (TCP). A TCP
+           subscriber on the broker timestamps each arrival.
+
+        Part 2 needs a running broker and gateway, e.g.:
+          docker compose up mosquitto
+          (cd host/mqttsn && MQTT-SNGateway -f gateway.conf)
+
+        Usage:
+          mqttsn_bench [--broker HOST:PORT] [--gateway HOST:PORT]
+                       [--count N] [--qos -1|0|1] [--offline]
+*/
+
+#include "../../include/MqttSn.hpp"
+#include "MqttClient.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// Header sizes without options: IPv4 20, UDP 8, TCP 20
+#define IPV4_UDP_OVERHEAD 28
+#define IPV4_TCP_OVERHEAD 40
+
+// Predefined topic ID of bench/latency in host/mqttsn/predefinedTopic.conf
+#define BENCH_TOPIC "bench/latency"
+#define BENCH_TOPIC_ID 100
+
+// Local UDP port; must match the sn-bench entry in host/mqttsn/clients.conf
+#define BENCH_LOCAL_PORT 10001
+
+#define RECEIVE_TIMEOUT_MS 1000
+
+// Consecutive missing PUBACKs after which the QoS 1 run is abandoned
+#define MAX_MISSED_ACKS 3
+
+struct Options {
+  std::string brokerHost = "127.0.0.1";
+  uint16_t brokerPort = 1883;
+  std::string gatewayHost = "127.0.0.1";
+  uint16_t gatewayPort = MQTTSN_DEFAULT_PORT;
+  int count = 1000;
+  int qos = -1;
+  bool offline = false;
+};
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--broker") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.brokerHost, opt.brokerPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--gateway") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.gatewayHost, opt.gatewayPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--count") && hasValue) {
+      opt.count = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--qos") && hasValue) {
+      opt.qos = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--offline")) {
+      opt.offline = true;
+    } else {
+      return false;
+    }
+  }
+  return opt.count > 0 && opt.qos >= -1 && opt.qos <= 1;
+}
+
+/*
+        Part 1: compare encoded sizes for the topics and typical
+        payloads that main.cpp publishes every publishInterval.
+*/
+static void reportWireBytes() {
+  struct Sample {
+    const char *topic;
+    uint16_t topicId;
+    const char *payload;
+  };
+  static const Sample samples[] = {
+      {"Lx", 3, "412"},           {"Door", 2, "Closed"},
+      {"Humidity", 7, "48.00"},   {"Temperature", 5, "22.00"},
+      {"FeltTemperature", 8, "21.73"},
+  };
+
+  std::vector<uint8_t> tcp;
+  uint8_t sn[MQTTSN_MAX_PACKET];
+  size_t tcpTotal = 0, snTotal = 0;
+
+  printf("== Bytes per publish (payload+MQTT / incl. IPv4+TCP|UDP) ==\n");
+  printf("%-16s %8s %8s %10s %10s\n", "topic", "mqtt", "mqtt-sn", "tcp+ip",
+         "udp+ip");
+  for (const Sample &s : samples) {
+    size_t len = strlen(s.payload);
+    MqttClient::encodePublish(tcp, s.topic, s.payload, len, false);
+    size_t snLen = mqttsnPublish(sn, sizeof(sn), 0, false,
+                                 MQTTSN_TOPIC_PREDEFINED, s.topicId, 0,
+                                 (const uint8_t *)s.payload, len);
+    printf("%-16s %8zu %8zu %10zu %10zu\n", s.topic, tcp.size(), snLen,
+           tcp.size() + IPV4_TCP_OVERHEAD, snLen + IPV4_UDP_OVERHEAD);
+    tcpTotal += tcp.size() + IPV4_TCP_OVERHEAD;
+    snTotal += snLen + IPV4_UDP_OVERHEAD;
+  }
+  printf("%-16s %8s %8s %10zu %10zu\n", "cycle total", "", "", tcpTotal,
+         snTotal);
+  printf("TCP additionally costs one %d-byte ACK segment per publish unless\n"
+         "delayed ACKs coalesce them, plus a 3-way handshake and CONNECT/\n"
+         "CONNACK on every reconnect; QoS -1 MQTT-SN needs no session.\n\n",
+         IPV4_TCP_OVERHEAD);
+}
+
+static void reportLatency(const char *name, std::vector<double> &us,
+                          int expected, uint64_t bytes, int published) {
+  double bytesPerMsg = published > 0 ? (double)bytes / published : 0;
+  if (us.empty()) {
+    printf("%-10s no messages received\n", name);
+    return;
+  }
+  std::sort(us.begin(), us.end());
+  auto pct = [&](double p) {
+    size_t i = (size_t)(p * (us.size() - 1));
+    return us[i];
+  };
+  printf("%-10s recv %5zu/%-5d p50 %8.1f  p90 %8.1f  p99 %8.1f  max %8.1f us"
+         "  %.1f B/msg sent\n",
+         name, us.size(), expected, pct(0.50), pct(0.90), pct(0.99),
+         us.back(), bytesPerMsg);
+}
+
+// Wait for the subscriber to see the payload tagged with seq
+static bool awaitSequence(MqttClient &sub, int seq) {
+  bool seen = false;
+  int64_t deadline = monotonicMs() + RECEIVE_TIMEOUT_MS;
+  char want[16];
+  int wantLen = snprintf(want, sizeof(want), "%d", seq);
+
+  while (!seen && monotonicMs() < deadline) {
+    if (!sub.poll(1, [&](const char *, size_t, const uint8_t *p, size_t n) {
+          if (n == (size_t)wantLen && !memcmp(p, want, n)) {
+            seen = true;
+          }
+        })) {
+      return false;
+    }
+  }
+  return seen;
+}
+
+static bool benchTcp(const Options &opt, MqttClient &sub) {
+  MqttClient pub;
+  if (!pub.connect(opt.brokerHost, opt.brokerPort, "tcp-bench")) {
+    fprintf(stderr, "tcp: cannot connect to broker\n");
+    return false;
+  }
+
+  std::vector<double> us;
+  uint64_t before = pub.bytesSent();
+  int published = 0;
+  char payload[16];
+  for (int seq = 0; seq < opt.count; seq++) {
+    snprintf(payload, sizeof(payload), "%d", seq);
+    int64_t t0 = monotonicNs();
+    if (!pub.publish(BENCH_TOPIC, payload)) {
+      break;
+    }
+    published++;
+    if (awaitSequence(sub, seq)) {
+      us.push_back((monotonicNs() - t0) / 1000.0);
+    }
+  }
+  reportLatency("mqtt/tcp", us, opt.count, pub.bytesSent() - before,
+                published);
+  return true;
+}
+
+// Send one MQTT-SN datagram and optionally wait for a reply type
+static bool snExchange(int fd, const uint8_t *pkt, size_t len, uint8_t reply,
+                       uint64_t &sent) {
+  if (send(fd, pkt, len, 0) != (ssize_t)len) {
+    return false;
+  }
+  sent += len;
+  if (reply == 0xFF) {
+    return true;
+  }
+
+  int64_t deadline = monotonicMs() + RECEIVE_TIMEOUT_MS;
+  uint8_t rx[MQTTSN_MAX_PACKET];
+  MqttSnPacket in;
+  while (monotonicMs() < deadline) {
+    pollfd pfd{fd, POLLIN, 0};
+    if (poll(&pfd, 1, (int)(deadline - monotonicMs())) <= 0) {
+      continue;
+    }
+    ssize_t n = recv(fd, rx, sizeof(rx), 0);
+    if (n > 0 && mqttsnParse(rx, (size_t)n, &in) && in.type == reply) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool benchMqttSn(const Options &opt, MqttClient &sub) {
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in local{}, gw{};
+  local.sin_family = AF_INET;
+  local.sin_port = htons(BENCH_LOCAL_PORT);
+  gw.sin_family = AF_INET;
+  gw.sin_port = htons(opt.gatewayPort);
+  if (fd < 0 || inet_pton(AF_INET, opt.gatewayHost.c_str(), &gw.sin_addr) != 1 ||
+      bind(fd, (sockaddr *)&local, sizeof(local)) != 0 ||
+      connect(fd, (sockaddr *)&gw, sizeof(gw)) != 0) {
+    fprintf(stderr, "mqtt-sn: cannot open UDP socket to gateway\n");
+    if (fd >= 0) {
+      close(fd);
+    }
+    return false;
+  }
+
+  uint8_t pkt[MQTTSN_MAX_PACKET];
+  uint64_t sent = 0;
+  if (opt.qos >= 0) {
+    size_t len = mqttsnConnect(pkt, sizeof(pkt), "sn-bench", 60, true);
+    if (!snExchange(fd, pkt, len, MQTTSN_CONNACK, sent)) {
+      fprintf(stderr, "mqtt-sn: no CONNACK from gateway\n");
+      close(fd);
+      return false;
+    }
+  }
+
+  std::vector<double> us;
+  uint64_t before = sent;
+  int published = 0, missedAcks = 0;
+  bool ok = true;
+  char payload[16];
+  for (int seq = 0; seq < opt.count; seq++) {
+    int n = snprintf(payload, sizeof(payload), "%d", seq);
+    // Message ID 0 is reserved, so IDs cycle through 1..65535
+    uint16_t msgId = (uint16_t)(seq % 65535 + 1);
+    size_t len = mqttsnPublish(pkt, sizeof(pkt), (int8_t)opt.qos, false,
+                               MQTTSN_TOPIC_PREDEFINED, BENCH_TOPIC_ID, msgId,
+                               (const uint8_t *)payload, (size_t)n);
+    int64_t t0 = monotonicNs();
+    uint64_t sentBefore = sent;
+    bool acked =
+        snExchange(fd, pkt, len, opt.qos == 1 ? MQTTSN_PUBACK : 0xFF, sent);
+    if (sent > sentBefore) {
+      published++;
+    }
+    if (!acked) {
+      if (opt.qos == 1 && ++missedAcks >= MAX_MISSED_ACKS) {
+        fprintf(stderr, "mqtt-sn: %d PUBACKs in a row missing, giving up\n",
+                missedAcks);
+        ok = false;
+        break;
+      }
+      continue;
+    }
+    missedAcks = 0;
+    if (awaitSequence(sub, seq)) {
+      us.push_back((monotonicNs() - t0) / 1000.0);
+    } else if (us.empty() && seq >= 2) {
+      fprintf(stderr, "mqtt-sn: nothing forwarded; is the gateway running?\n");
+      break;
+    }
+  }
+
+  char name[16];
+  snprintf(name, sizeof(name), "sn/qos%d", opt.qos);
+  reportLatency(name, us, opt.count, sent - before, published);
+
+  if (opt.qos >= 0) {
+    size_t len = mqttsnDisconnect(pkt, sizeof(pkt), 0);
+    snExchange(fd, pkt, len, 0xFF, sent);
+  }
+  close(fd);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    fprintf(stderr,
+            "usage: %s [--broker HOST:PORT] [--gateway HOST:PORT] "
+            "[--count N] [--qos -1|0|1] [--offline]\n",
+            argv[0]);
+    return 2;
+  }
+
+  reportWireBytes();
+  if (opt.offline) {
+    return 0;
+  }
+
+  MqttClient sub;
+  if (!sub.connect(opt.brokerHost, opt.brokerPort, "bench-subscriber") ||
+      !sub.subscribe(BENCH_TOPIC)) {
+    fprintf(stderr, "cannot subscribe on broker %s:%u\n",
+            opt.brokerHost.c_str(), opt.brokerPort);
+    return 1;
+  }
+
+  printf("== Publish-to-subscribe latency, %d messages ==\n", opt.count);
+  bool ok = benchTcp(opt, sub);
+  ok = benchMqttSn(opt, sub) && ok;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,312 @@
+/*
+        Rule engine checks and evaluation cost on the host
+
+        First checks the compiler (errors, operator and clause
+        binding) and the timing semantics (for, debounce,
+        cooldown), and that the rule set from main.cpp fires as
+        expected over one simulated day. Exits non-zero if any
+        check fails.
+
+        Then times the firmware rules and a worst-case table
+        (RULE_MAX_RULES rules x RULE_MAX_TERMS terms) against
+        two sample streams, random noise and the simulated day:
+        every tick updates the door, every 50th tick updates the
+        remaining signals, and every tick calls evaluate(), like
+        loop() does on the node.
+
+        Usage:
+          rules_bench [--ticks N]
+*/
+
+#include "../../include/RuleEngine.hpp"
+#include "MqttClient.hpp"
+#include "Xorshift.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// Same text as alertRules in src/main.cpp
+static const char *firmwareRules =
+    "lights_on_empty : lux > 300 & presence == 0 for 10m ; cooldown 15m\n"
+    "door_left_open  : door == 1 for 5m ; cooldown 10m\n"
+    "too_hot         : heatindex > 28 ; debounce 60s ; cooldown 30m\n"
+    "too_humid       : humidity > 70 ; debounce 60s ; cooldown 30m\n";
+
+#define TICK_MS 10
+#define DAY_MS (24 * 3600000u)
+
+static unsigned alerts = 0;
+
+static void countAlert(const char *, uint32_t) { alerts++; }
+
+// Names of the rules fired so far, for the checks
+static std::string fired;
+
+static void recordAlert(const char *ruleName, uint32_t) {
+  fired += ruleName;
+  fired += ' ';
+}
+
+// Every rule uses the maximum number of terms, spread over all signals
+static std::string worstCaseRules() {
+  static const char *names[] = {"lux",      "door",     "presence",
+                                "temperature", "humidity", "heatindex"};
+  std::string text;
+  char line[160];
+  for (int r = 0; r < RULE_MAX_RULES; r++) {
+    int n = snprintf(line, sizeof(line), "rule%d :", r);
+    for (int t = 0; t < RULE_MAX_TERMS; t++) {
+      n += snprintf(line + n, sizeof(line) - n, "%s %s > %d for %ds",
+                    t ? " &" : "", names[(r + t) % 6], r % 7, t);
+    }
+    snprintf(line + n, sizeof(line) - n, " ; debounce 1s ; cooldown 1m\n");
+    text += line;
+  }
+  return text;
+}
+
+static Xorshift rng(2463534242u);
+
+typedef void (*Trace)(RuleEngine &engine, long tick, uint32_t now);
+
+// Door blips at random, the other signals jump around at random
+static void noiseTrace(RuleEngine &engine, long i, uint32_t now) {
+  uint32_t r = rng.next();
+  engine.update(SIG_DOOR, (r >> 8) % 1000 == 0 ? (float)(r & 1) : 0.0f, now);
+  if (i % 50 == 0) {
+    engine.update(SIG_LUX, (float)(r % 600), now);
+    engine.update(SIG_PRESENCE, (float)((r >> 3) & 1), now);
+    engine.update(SIG_TEMPERATURE, 18.0f + (r >> 4) % 14, now);
+    engine.update(SIG_HUMIDITY, 30.0f + (r >> 6) % 50, now);
+    engine.update(SIG_HEAT_INDEX, 18.0f + (r >> 9) % 14, now);
+  }
+}
+
+/*
+        One office day, repeating. The room is occupied 8:00-17:00
+        with a lunch break at 12:00 and lit 7:30-19:00, so the
+        lights burn in an empty room three times. The door opens
+        for 30 s every hour and stays open 9:00-9:10. The heat
+        index peaks at 30 C mid-afternoon and humidity at 75 % in
+        the morning, each above its threshold for about 6 hours.
+*/
+static void dayTrace(RuleEngine &engine, long i, uint32_t now) {
+  double hour = fmod(now / 3600000.0, 24.0);
+  double minute = fmod(now / 60000.0, 60.0);
+  bool door = minute < 0.5 || (hour >= 9 && hour < 9 + 10 / 60.0);
+  engine.update(SIG_DOOR, door ? 1.0f : 0.0f, now);
+  if (i % 50 == 0) {
+    bool present = hour >= 8 && hour < 17 && !(hour >= 12 && hour < 13);
+    bool lit = hour >= 7.5 && hour < 19;
+    double phase = 2 * M_PI / 24;
+    engine.update(SIG_PRESENCE, present ? 1.0f : 0.0f, now);
+    engine.update(SIG_LUX, lit ? 450.0f : 5.0f, now);
+    engine.update(SIG_TEMPERATURE, (float)(23 + 5 * sin(phase * (hour - 9))),
+                  now);
+    engine.update(SIG_HEAT_INDEX, (float)(24 + 6 * sin(phase * (hour - 9))),
+                  now);
+    engine.update(SIG_HUMIDITY, (float)(60 + 15 * sin(phase * (hour - 3))),
+                  now);
+  }
+}
+
+static void run(const char *label, const char *config, Trace trace,
+                long ticks) {
+  RuleEngine engine;
+  char error[64];
+
+  int64_t t0 = monotonicNs();
+  if (!engine.compile(config, error, sizeof(error))) {
+    fprintf(stderr, "%s: %s\n", label, error);
+    exit(1);
+  }
+  int64_t compileNs = monotonicNs() - t0;
+
+  // One tick per loop() iteration
+  alerts = 0;
+  uint32_t now = 0;
+  t0 = monotonicNs();
+  for (long i = 0; i < ticks; i++, now += TICK_MS) {
+    trace(engine, i, now);
+    engine.evaluate(now, countAlert);
+  }
+  double ns = (double)(monotonicNs() - t0) / ticks;
+
+  printf("%-18s rules %2u  compile %7.1f us  tick %7.1f ns  alerts %u\n",
+         label, engine.ruleCount(), compileNs / 1000.0, ns, alerts);
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// compile() must accept text iff error is null, else report that message
+static void expectCompile(const char *text, const char *error) {
+  RuleEngine engine;
+  char got[64] = "";
+  bool ok = engine.compile(text, got, sizeof(got));
+  if (error ? ok || strcmp(got, error) != 0 : !ok) {
+    printf("FAILED: compile \"%s\": expected %s, got %s\n", text,
+           error ? error : "success", ok ? "success" : got);
+    failures++;
+  } else if (!ok) {
+    check(engine.ruleCount() == 0, "failed compile leaves rules behind");
+  }
+}
+
+static void checkCompiler() {
+  expectCompile("# only a comment\n\n", nullptr);
+  expectCompile("a : lux > 300 & presence == 0 for 10m ; cooldown 15m",
+                nullptr);
+  expectCompile("a : lux > 1 for 596h", nullptr);
+
+  expectCompile("a lux > 1", "line 1: expected ':' after the rule name");
+  expectCompile("a : noise > 1", "line 1: unknown signal");
+  expectCompile("a : lux => 1", "line 1: expected one of > < >= <= == !=");
+  expectCompile("a : lux > ", "line 1: expected a number");
+  expectCompile("a : lux > nan", "line 1: expected a number");
+  expectCompile("a : lux < -inf", "line 1: expected a number");
+  expectCompile("a : lux > 1 for 10", "line 1: duration needs an s, m or h "
+                                      "suffix");
+  expectCompile("a : lux > 1 for -1s", "line 1: expected a duration");
+  expectCompile("a : lux > 1 for 597h",
+                "line 1: duration too long (max 596h)");
+  expectCompile("a : lux > 1 ; cooldown 1e30h",
+                "line 1: duration too long (max 596h)");
+  expectCompile("a : lux > 1 ; snooze 1m",
+                "line 1: expected 'debounce' or 'cooldown'");
+  expectCompile("a : lux > 1 | door == 1", "line 1: unexpected text after "
+                                           "rule");
+  expectCompile("a : lux > 1 & door == 1 & lux < 9 & door != 0 & lux > 2",
+                "line 1: too many terms in rule");
+  expectCompile("a_name_of_twenty_four_ch : lux > 1",
+                "line 1: expected a rule name (max 23 characters)");
+  expectCompile("a : lux > 1\n\n# comment\nb : door == 1 for 5\n",
+                "line 4: duration needs an s, m or h suffix");
+
+  std::string tooMany;
+  for (int r = 0; r <= RULE_MAX_RULES; r++) {
+    tooMany += "r" + std::to_string(r) + " : lux > 1\n";
+  }
+  expectCompile(tooMany.c_str(), "line 17: too many rules");
+}
+
+// Fire times of rule text under a scripted sequence of (time, signal, value)
+struct Step {
+  uint32_t at;
+  uint8_t signal;
+  float value;
+};
+
+static std::string alertTimes(const char *config, const Step *steps,
+                              size_t count, uint32_t until) {
+  RuleEngine engine;
+  if (!engine.compile(config)) {
+    return "compile error";
+  }
+  std::string times;
+  size_t next = 0;
+  for (uint32_t now = 0; now <= until; now += TICK_MS) {
+    for (; next < count && steps[next].at <= now; next++) {
+      engine.update(steps[next].signal, steps[next].value, now);
+    }
+    if (engine.evaluate(now, nullptr)) {
+      times += std::to_string(now / 1000) + "s ";
+    }
+  }
+  return times;
+}
+
+static void checkSemantics() {
+  // Two-character operators bind before their one-character prefixes
+  static const Step atThreshold[] = {{0, SIG_LUX, 300}};
+  check(alertTimes("a : lux >= 300", atThreshold, 1, 1000) == "0s ",
+        ">= fires at the threshold");
+  check(alertTimes("a : lux > 300", atThreshold, 1, 1000).empty(),
+        "> does not fire at the threshold");
+
+  // 'for' binds to its own term; the door term is true at once
+  static const Step late[] = {{0, SIG_PRESENCE, 0}, {90000, SIG_DOOR, 1}};
+  check(alertTimes("a : door == 1 & presence == 0 for 1m", late, 2, 120000) ==
+            "90s ",
+        "for applies to its own term only");
+  static const Step early[] = {{0, SIG_DOOR, 1}, {30000, SIG_PRESENCE, 0}};
+  check(alertTimes("a : door == 1 & presence == 0 for 1m", early, 2, 120000) ==
+            "90s ",
+        "for counts from when its own term became true");
+
+  // Debounce: a 5 s blip is ignored, a 20 s opening fires after 10 s.
+  // Cooldown: reopening at 60 s waits until 1 minute after the last alert.
+  static const Step door[] = {{0, SIG_DOOR, 1},      {5000, SIG_DOOR, 0},
+                              {10000, SIG_DOOR, 1},  {30000, SIG_DOOR, 0},
+                              {60000, SIG_DOOR, 1},  {100000, SIG_DOOR, 0}};
+  check(alertTimes("a : door == 1 ; debounce 10s ; cooldown 1m", door, 6,
+                   120000) == "20s 80s ",
+        "debounce and cooldown");
+
+  // Signals never sampled keep their terms false
+  static const Step luxOnly[] = {{0, SIG_LUX, 500}};
+  check(alertTimes("a : lux > 300 & presence == 0", luxOnly, 1, 60000).empty(),
+        "unsampled signal holds a rule false");
+}
+
+// Door opened at t=0 and left open: exactly one alert after 5 minutes
+static void checkDoorScenario() {
+  RuleEngine engine;
+  engine.compile(firmwareRules);
+  alerts = 0;
+  bool onTime = true;
+  for (uint32_t now = 0; now <= 20 * 60000; now += TICK_MS) {
+    engine.update(SIG_DOOR, 1, now);
+    if (engine.evaluate(now, countAlert) && now != 5 * 60000) {
+      onTime = false;
+    }
+  }
+  check(onTime && alerts == 1, "door left open fires once after 5 minutes");
+}
+
+// The firmware rules over one simulated day, in firing order
+static void checkDayTrace() {
+  RuleEngine engine;
+  engine.compile(firmwareRules);
+  fired.clear();
+  long i = 0;
+  for (uint32_t now = 0; now < DAY_MS; now += TICK_MS, i++) {
+    dayTrace(engine, i, now);
+    engine.evaluate(now, recordAlert);
+  }
+  printf("day trace alerts: %s\n", fired.c_str());
+  check(fired == "too_humid lights_on_empty door_left_open too_hot "
+                 "lights_on_empty lights_on_empty ",
+        "firmware rules over one day");
+}
+
+int main(int argc, char **argv) {
+  long ticks = 10000000;
+  if (argc == 3 && !strcmp(argv[1], "--ticks")) {
+    ticks = atol(argv[2]);
+  } else if (argc != 1) {
+    fprintf(stderr, "usage: %s [--ticks N]\n", argv[0]);
+    return 2;
+  }
+
+  checkCompiler();
+  checkSemantics();
+  checkDoorScenario();
+  checkDayTrace();
+  printf("checks: %s\n", failures ? "FAILED" : "ok");
+
+  run("firmware/noise", firmwareRules, noiseTrace, ticks);
+  run("firmware/day", firmwareRules, dayTrace, ticks);
+  run("worst-case/noise", worstCaseRules().c_str(), noiseTrace, ticks);
+  run("worst-case/day", worstCaseRules().c_str(), dayTrace, ticks);
+  return failures ? 1 : 0;
+}
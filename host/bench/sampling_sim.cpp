@@ -0,0 +1,406 @@
+/*
+        Adaptive vs fixed sampling simulation
+
+        Replays a sensor trace through two schedulers and reports
+        sensor reads (bus/CPU activity), MQTT publishes (radio
+        activity) and how quickly each one notices changes:
+
+          fixed     every sensor read every 5 s (previous firmware)
+          adaptive  AdaptiveSampler per sensor, boosted on door
+                    and radar presence edges, mirroring loop()
+                    in src/main.cpp
+
+        Trace CSV, one row per tick, header line optional:
+          t_ms,lux,door,presence,temperature,humidity
+
+        Without --trace a synthetic classroom day is generated
+        (lectures, breaks, a forgotten light); --dump writes it
+        out so it can be inspected or replaced by recorded data.
+
+        Before that, a few scripted signals check the sampler's
+        activity detection; the program exits non-zero if one
+        fails.
+
+        Usage:
+          sampling_sim [--trace FILE]... [--dump FILE]
+*/
+
+#include "../../include/AdaptiveSampler.hpp"
+#include "../../include/SamplingConfig.hpp"
+#include "Xorshift.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Previous firmware behaviour
+#define FIXED_INTERVAL_MS 5000
+
+// A jump of this many lux between two trace rows is a light switching
+#define LUX_EVENT 100.0f
+
+struct Row {
+  uint32_t t;
+  float lux;
+  bool door;
+  bool presence;
+  float temperature;
+  float humidity;
+};
+
+struct Trace {
+  std::string name;
+  std::vector<Row> rows;
+};
+
+// Deterministic noise source so runs are comparable
+static Xorshift rng(22222u);
+static float noise() {
+  return (float)(rng.next() % 20001) / 10000.0f - 1.0f; // -1..1
+}
+
+/*
+        Synthetic day at 100 ms resolution. Four lectures with
+        students arriving and leaving through the door, lights
+        switched on shortly after the first arrival and off by
+        the last one out, daylight through the windows, the room
+        warming up and getting more humid while occupied, and the
+        lights forgotten on until a guard comes by at 19:00.
+        Times are deliberately not multiples of 5 s, and lights
+        switch a fraction of a second off the door edges, so
+        neither the fixed 5 s grid nor the boosted 1 s grid that
+        starts at a door edge is aligned with the events.
+*/
+static Trace syntheticDay() {
+  struct Lecture {
+    float start, end;          // seconds since midnight
+    float lightsOn, lightsOff; // after the first arrival / the end
+  };
+  static const Lecture lectures[] = {
+      {8 * 3600 + 2447, 10 * 3600 + 1803, 17.4f, 152.7f},
+      {10 * 3600 + 3311, 12 * 3600 + 1789, 22.7f, 147.3f},
+      {13 * 3600 + 3067, 15 * 3600 + 1823, 15.2f, 155.8f},
+      {15 * 3600 + 3443, 17 * 3600 + 1777, 19.6f, 150.1f}};
+
+  Trace trace;
+  trace.name = "synthetic day";
+  float temperature = 19.0f;
+  float humidity = 45.0f;
+
+  for (uint32_t t = 0; t < 24u * 3600u * 1000u; t += 100) {
+    float sec = t / 1000.0f;
+    bool occupied = false, lights = false, door = false;
+
+    for (const Lecture &l : lectures) {
+      float arriving = sec - l.start;
+      float leaving = sec - l.end;
+      occupied |= arriving >= 0 && leaving < 180;
+      // Door opens in bursts while people arrive and leave
+      door |= arriving >= 0 && arriving < 300 && fmodf(arriving, 41) < 13;
+      door |= leaving >= 0 && leaving < 180 && fmodf(leaving, 31) < 14;
+      // First one in switches on, last one out switches off
+      lights |= arriving >= l.lightsOn && leaving < l.lightsOff;
+    }
+
+    // Cleaner in the morning
+    float cleaner = sec - (7 * 3600 + 2713);
+    door |= cleaner >= 0 && cleaner < 9;
+    lights |= cleaner >= 6.3f && cleaner < 899.6f;
+    door |= cleaner >= 897 && cleaner < 905;
+
+    // Light left on after the last lecture until the guard's round
+    lights |= sec >= lectures[3].end + lectures[3].lightsOff &&
+              sec < 19 * 3600 + 7.6f;
+    float guard = sec - 19 * 3600;
+    door |= guard >= 0 && guard < 12;
+
+    float h = sec / 3600.0f;
+    float daylight = h > 7 && h < 19 ? 150.0f * sinf(3.14159f * (h - 7) / 12)
+                                     : 0.0f;
+    float lux = 2.0f + daylight + (lights ? 450.0f : 0.0f) + 3.0f * noise();
+
+    // First-order drift towards a target that depends on occupancy
+    float targetT = occupied ? 25.0f : 19.0f;
+    float targetH = occupied ? 60.0f : 45.0f;
+    temperature += (targetT - temperature) * 0.1f / 3600.0f * 2.0f;
+    humidity += (targetH - humidity) * 0.1f / 3600.0f * 4.0f;
+
+    // DHT11 reports whole degrees and percent
+    trace.rows.push_back({t, std::max(lux, 0.0f), door, occupied,
+                          roundf(temperature), roundf(humidity)});
+  }
+  return trace;
+}
+
+static bool loadTrace(const char *path, Trace &trace) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    return false;
+  }
+  trace.name = path;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    Row r;
+    int door, presence;
+    if (sscanf(line, "%u,%f,%d,%d,%f,%f", &r.t, &r.lux, &door, &presence,
+               &r.temperature, &r.humidity) == 6) {
+      r.door = door != 0;
+      r.presence = presence != 0;
+      trace.rows.push_back(r);
+    }
+  }
+  fclose(f);
+  return !trace.rows.empty();
+}
+
+static void dumpTrace(const char *path, const Trace &trace) {
+  FILE *f = fopen(path, "w");
+  if (!f) {
+    perror(path);
+    return;
+  }
+  fprintf(f, "t_ms,lux,door,presence,temperature,humidity\n");
+  for (const Row &r : trace.rows) {
+    fprintf(f, "%u,%.1f,%d,%d,%.1f,%.1f\n", r.t, r.lux, r.door, r.presence,
+            r.temperature, r.humidity);
+  }
+  fclose(f);
+}
+
+struct Result {
+  unsigned luxReads = 0;
+  unsigned climateReads = 0;
+  unsigned publishes = 0;
+  std::vector<double> luxDelays;  // ms from light switching to next read
+  std::vector<double> doorDelays; // ms from a door edge to its publish
+  double tempErrorSum = 0;        // integral of |truth - last read|
+};
+
+/*
+        Walk the trace once. For every light switching or door
+        edge in the ground truth, remember when it happened and
+        record the delay until the scheduler reports it.
+*/
+static Result simulate(const Trace &trace, bool adaptive) {
+  AdaptiveSampler lux(LUX_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                      LUX_THRESHOLD);
+  AdaptiveSampler climate(CLIMATE_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                          CLIMATE_THRESHOLD);
+  Result res;
+  uint32_t lastFixed = 0;
+  bool first = true;
+  bool lastDoor = trace.rows[0].door;
+  bool lastPresence = trace.rows[0].presence;
+  float lastHumidity = trace.rows[0].humidity;
+  float readTemperature = trace.rows[0].temperature;
+  int64_t luxEventAt = -1, doorEventAt = -1;
+
+  for (size_t i = 0; i < trace.rows.size(); i++) {
+    const Row &r = trace.rows[i];
+    if (i > 0) {
+      const Row &p = trace.rows[i - 1];
+      if (fabsf(r.lux - p.lux) >= LUX_EVENT && luxEventAt < 0) {
+        luxEventAt = r.t;
+      }
+      if (r.door != p.door && doorEventAt < 0) {
+        doorEventAt = r.t;
+      }
+      res.tempErrorSum +=
+          fabs(r.temperature - readTemperature) * (r.t - p.t) / 1000.0;
+    }
+
+    bool luxDue, climateDue;
+    bool doorChanged = r.door != lastDoor;
+    lastDoor = r.door;
+    bool presenceChanged = r.presence != lastPresence;
+    lastPresence = r.presence;
+    if (adaptive) {
+      if (doorChanged || presenceChanged) {
+        lux.boost(r.t);
+        climate.boost(r.t);
+      }
+      luxDue = lux.due(r.t);
+      climateDue = climate.due(r.t);
+    } else {
+      luxDue = climateDue = first || r.t - lastFixed >= FIXED_INTERVAL_MS;
+      if (luxDue) {
+        lastFixed = r.t;
+      }
+      doorChanged = false; // the old firmware only sent door with the cycle
+    }
+    first = false;
+
+    if (doorChanged || luxDue) {
+      res.publishes++; // Door
+      if (doorEventAt >= 0) {
+        res.doorDelays.push_back(r.t - doorEventAt);
+        doorEventAt = -1;
+      }
+    }
+    if (luxDue) {
+      res.luxReads++;
+      res.publishes++;
+      lux.record(r.lux, r.t);
+      if (luxEventAt >= 0) {
+        res.luxDelays.push_back(r.t - luxEventAt);
+        luxEventAt = -1;
+      }
+    }
+    if (climateDue) {
+      res.climateReads++;
+      res.publishes += 3; // Humidity, Temperature, FeltTemperature
+      climate.record(r.temperature, r.t);
+      if (fabsf(r.humidity - lastHumidity) >= HUMIDITY_ACTIVITY) {
+        climate.boost(r.t);
+      }
+      lastHumidity = r.humidity;
+      readTemperature = r.temperature;
+    }
+  }
+  return res;
+}
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) {
+    return 0;
+  }
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(p * (v.size() - 1))];
+}
+
+static double mean(const std::vector<double> &v) {
+  double sum = 0;
+  for (double x : v) {
+    sum += x;
+  }
+  return v.empty() ? 0 : sum / v.size();
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  if (!ok) {
+    printf("FAILED: %s\n", what);
+    failures++;
+  }
+}
+
+// Poll sampler every trace row (100 ms) from..to against signal(t) and
+// return the shortest and longest interval between two reads
+template <typename Signal>
+static void follow(AdaptiveSampler &sampler, Signal signal, uint32_t from,
+                   uint32_t to, uint32_t &shortest, uint32_t &longest) {
+  int64_t last = -1;
+  shortest = UINT32_MAX;
+  longest = 0;
+  for (uint32_t t = from; t < to; t += 100) {
+    if (!sampler.due(t)) {
+      continue;
+    }
+    sampler.record(signal(t), t);
+    if (last >= 0) {
+      shortest = std::min(shortest, (uint32_t)(t - last));
+      longest = std::max(longest, (uint32_t)(t - last));
+    }
+    last = t;
+  }
+}
+
+static void checkSampler() {
+  uint32_t shortest, longest;
+
+  // Daylight-like drift of 0.3 lx/s: 18 lx between two reads at the base
+  // interval, close to the threshold, but far from volatile per second
+  AdaptiveSampler drift(LUX_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                        LUX_THRESHOLD);
+  auto drifting = [](uint32_t t) { return 100.0f + 0.3f * t / 1000.0f; };
+  follow(drift, drifting, 0, 600000, shortest, longest);
+  follow(drift, drifting, 600000, 7200000, shortest, longest);
+  check(shortest == SAMPLE_BASE_INTERVAL_MS &&
+            longest == SAMPLE_BASE_INTERVAL_MS,
+        "slow drift stays at the base interval");
+
+  // 15 lx/s ramp after 10 quiet minutes: below the threshold per read at
+  // the minimum interval, but volatile, so followed at the minimum
+  AdaptiveSampler ramp(LUX_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                       LUX_THRESHOLD);
+  auto ramping = [](uint32_t t) {
+    float s = std::min(std::max(t / 1000.0f, 600.0f), 1200.0f);
+    return 100.0f + 15.0f * (s - 600.0f);
+  };
+  follow(ramp, ramping, 0, 600000, shortest, longest);
+  follow(ramp, ramping, 600000, 660000, shortest, longest);
+  follow(ramp, ramping, 660000, 1200000, shortest, longest);
+  check(shortest == LUX_MIN_INTERVAL_MS && longest == LUX_MIN_INTERVAL_MS,
+        "steady ramp is followed at the minimum interval");
+
+  // Once the ramp ends the volatility decays in time and the interval
+  // grows back to the base within five minutes
+  follow(ramp, ramping, 1200000, 1500000, shortest, longest);
+  check(ramp.interval() == SAMPLE_BASE_INTERVAL_MS,
+        "back to the base interval after the ramp");
+}
+
+static void report(const Trace &trace) {
+  double hours =
+      (trace.rows.back().t - trace.rows.front().t) / 3600000.0 + 1e-9;
+
+  printf("== %s (%.1f h, %zu rows) ==\n", trace.name.c_str(), hours,
+         trace.rows.size());
+  printf("%-9s %9s %9s %9s  %-24s %-24s %9s\n", "", "lux rd/h", "dht rd/h",
+         "pub/h", "light switch delay ms", "door edge delay ms", "temp err");
+  printf("%-9s %9s %9s %9s  %-24s %-24s %9s\n", "", "", "", "",
+         "mean / p95 / max", "mean / p95 / max", "degC avg");
+
+  for (int adaptive = 0; adaptive <= 1; adaptive++) {
+    Result r = simulate(trace, adaptive);
+    double duration = hours * 3600.0;
+    printf("%-9s %9.0f %9.0f %9.0f  %6.0f /%6.0f /%7.0f   %6.0f /%6.0f /%7.0f  "
+           " %9.3f\n",
+           adaptive ? "adaptive" : "fixed", r.luxReads / hours,
+           r.climateReads / hours, r.publishes / hours, mean(r.luxDelays),
+           percentile(r.luxDelays, 0.95), percentile(r.luxDelays, 1.0),
+           mean(r.doorDelays), percentile(r.doorDelays, 0.95),
+           percentile(r.doorDelays, 1.0), r.tempErrorSum / duration);
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  std::vector<Trace> traces;
+  const char *dump = nullptr;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+      Trace t;
+      if (!loadTrace(argv[++i], t)) {
+        fprintf(stderr, "cannot read trace %s\n", argv[i]);
+        return 1;
+      }
+      traces.push_back(std::move(t));
+    } else if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+      dump = argv[++i];
+    } else {
+      fprintf(stderr, "usage: %s [--trace FILE]... [--dump FILE]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  checkSampler();
+  printf("sampler checks: %s\n\n", failures ? "FAILED" : "ok");
+
+  if (traces.empty()) {
+    traces.push_back(syntheticDay());
+    if (dump) {
+      dumpTrace(dump, traces.back());
+    }
+  }
+  for (const Trace &t : traces) {
+    report(t);
+  }
+  return failures ? 1 : 0;
+}
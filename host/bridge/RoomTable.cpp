@@ -0,0 +1,312 @@
+#include "RoomTable.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static_assert(sizeof(RoomRecord) == 64, "room record is one cache line");
+
+#define IGNORED UINT64_MAX
+
+// JSON key of a field: the topic name of its metric
+static const char *fieldName(int field) {
+  return field == FIELD_ONLINE ? "online" : campusMetricNames[field];
+}
+
+static bool parseValue(RoomField field, const uint8_t *payload, size_t len,
+                       float &value) {
+  double reading;
+  if (!parseReading(field, payload, len, reading)) {
+    return false;
+  }
+  value = (float)reading;
+  return std::isfinite(value);
+}
+
+// Topic levels are arbitrary UTF-8; quote them as JSON strings
+static std::string jsonString(const std::string &s) {
+  std::string out = "\"";
+  for (unsigned char ch : s) {
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+      out += (char)ch;
+    } else if (ch < 0x20) {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", ch);
+      out += esc;
+    } else {
+      out += (char)ch;
+    }
+  }
+  return out + "\"";
+}
+
+RoomTable::RoomTable(int periodMs, bool diffs, const std::string &prefix)
+    : periodMs(periodMs), diffs(diffs), prefix(prefix), changed(0),
+      absorbed(0), lastOfflineCheck(0) {}
+
+uint64_t RoomTable::resolve(const std::string &topic) {
+  if (topic.compare(0, prefix.size(), prefix) == 0 &&
+      (topic.size() == prefix.size() || topic[prefix.size()] == '/')) {
+    return IGNORED; // Our own output
+  }
+
+  // Split off the metric; esp32/status counts as one level
+  std::string rest;
+  int field = -1;
+  size_t statusLen = strlen(CAMPUS_STATUS_TOPIC);
+  if (topic.size() >= statusLen &&
+      topic.compare(topic.size() - statusLen, statusLen,
+                    CAMPUS_STATUS_TOPIC) == 0 &&
+      (topic.size() == statusLen ||
+       topic[topic.size() - statusLen - 1] == '/')) {
+    field = FIELD_ONLINE;
+    rest = topic.substr(0, topic.size() - statusLen);
+  } else {
+    size_t slash = topic.rfind('/');
+    size_t name = slash == std::string::npos ? 0 : slash + 1;
+    field = campusMetric(topic.data() + name, topic.size() - name);
+    rest = slash == std::string::npos ? "" : topic.substr(0, slash + 1);
+  }
+  if (field < 0) {
+    return IGNORED;
+  }
+
+  // rest is "" or "<...>/"; its last level is the room, the rest the building
+  if (!rest.empty()) {
+    rest.pop_back();
+  }
+  size_t slash = rest.rfind('/');
+  std::string room = slash == std::string::npos ? rest : rest.substr(slash + 1);
+  std::string building =
+      slash == std::string::npos ? "" : rest.substr(0, slash);
+  if (room.empty()) {
+    room = BRIDGE_DEFAULT_NAME;
+  }
+  if (building.empty()) {
+    building = BRIDGE_DEFAULT_NAME;
+  }
+
+  auto b = buildingIndex.find(building);
+  uint16_t bi;
+  if (b != buildingIndex.end()) {
+    bi = b->second;
+  } else {
+    if (buildingList.size() > UINT16_MAX) {
+      return IGNORED;
+    }
+    bi = (uint16_t)buildingList.size();
+    buildingIndex[building] = bi;
+    buildingList.push_back(
+        Building{building, prefix + "/" + building, {}, {}, 0, 0, false});
+  }
+
+  std::string roomKey = building + "/" + room;
+  auto r = roomIndex.find(roomKey);
+  uint32_t ri;
+  if (r != roomIndex.end()) {
+    ri = r->second;
+  } else {
+    ri = (uint32_t)table.size();
+    roomIndex[roomKey] = ri;
+    RoomRecord rec{};
+    rec.building = bi;
+    table.push_back(rec);
+    roomNames.push_back(jsonString(room));
+    buildingList[bi].rooms.push_back(ri);
+  }
+  return (uint64_t)ri << 8 | (uint64_t)field;
+}
+
+bool RoomTable::update(const char *topic, size_t topicLen,
+                       const uint8_t *payload, size_t payloadLen,
+                       int64_t nowMs) {
+  key.assign(topic, topicLen);
+  auto it = topics.find(key);
+  uint64_t ref;
+  if (it != topics.end()) {
+    ref = it->second;
+  } else {
+    ref = resolve(key);
+    topics.emplace(key, ref);
+  }
+  if (ref == IGNORED) {
+    return false;
+  }
+
+  RoomField field = (RoomField)(ref & 0xFF);
+  float value = 0;
+  if (field != FIELD_ONLINE && !parseValue(field, payload, payloadLen, value)) {
+    return false;
+  }
+
+  // Any message, status or reading, means the node is up
+  uint32_t room = (uint32_t)(ref >> 8);
+  table[room].lastSeen = nowMs;
+  bool roomChanged = set(room, FIELD_ONLINE, 1);
+  if (field != FIELD_ONLINE) {
+    roomChanged = set(room, field, value) || roomChanged;
+  }
+  if (!roomChanged) {
+    absorbed++;
+    return false;
+  }
+  changed++;
+  return true;
+}
+
+bool RoomTable::set(uint32_t room, RoomField field, float value) {
+  RoomRecord &r = table[room];
+  uint16_t bit = (uint16_t)(1u << field);
+  if ((r.present & bit) && r.value[field] == value) {
+    return false;
+  }
+  r.value[field] = value;
+  r.present |= bit;
+  r.dirty |= bit;
+
+  if (!r.queued) {
+    r.queued = 1;
+    Building &b = buildingList[r.building];
+    if (b.dirtyRooms.empty()) {
+      pendingBuildings.push_back(r.building);
+    }
+    b.dirtyRooms.push_back(room);
+  }
+  return true;
+}
+
+void RoomTable::checkOffline(int64_t nowMs) {
+  if (nowMs - lastOfflineCheck < BRIDGE_OFFLINE_CHECK_MS) {
+    return;
+  }
+  lastOfflineCheck = nowMs;
+  for (uint32_t room = 0; room < table.size(); room++) {
+    const RoomRecord &r = table[room];
+    if (r.value[FIELD_ONLINE] != 0 && nowMs - r.lastSeen >= BRIDGE_OFFLINE_MS) {
+      set(room, FIELD_ONLINE, 0);
+    }
+  }
+}
+
+void RoomTable::appendRoom(std::string &out, uint32_t room, uint16_t fields,
+                           bool seen) const {
+  const RoomRecord &r = table[room];
+  char buf[64];
+
+  out += roomNames[room];
+  out += ":{";
+  bool first = true;
+  for (int f = 0; f < FIELD_COUNT; f++) {
+    if (!(fields & r.present & (1u << f))) {
+      continue;
+    }
+    float v = r.value[f];
+    const char *text = f == FIELD_ONLINE ? nullptr : readingText(f, v);
+    int n;
+    if (text) {
+      n = snprintf(buf, sizeof(buf), "\"%s\":\"%s\"", fieldName(f), text);
+    } else if (f == FIELD_ONLINE) {
+      n = snprintf(buf, sizeof(buf), "\"%s\":%s", fieldName(f),
+                   v != 0 ? "true" : "false");
+    } else {
+      n = snprintf(buf, sizeof(buf), "\"%s\":%g", fieldName(f), v);
+    }
+    if (!first) {
+      out += ',';
+    }
+    out.append(buf, (size_t)n);
+    first = false;
+  }
+  if (seen) {
+    int n = snprintf(buf, sizeof(buf), "%s\"seen\":%lld", first ? "" : ",",
+                     (long long)r.lastSeen);
+    out.append(buf, (size_t)n);
+  }
+  out += '}';
+}
+
+void RoomTable::snapshot(size_t bi, int64_t nowMs, std::string &out) const {
+  const Building &b = buildingList[bi];
+  char head[96];
+  snprintf(head, sizeof(head), "{\"time\":%lld,\"rooms\":{",
+           (long long)nowMs);
+  out = head;
+  for (size_t i = 0; i < b.rooms.size(); i++) {
+    if (i) {
+      out += ',';
+    }
+    appendRoom(out, b.rooms[i], 0xFFFF, true);
+  }
+  out += "}}";
+}
+
+void RoomTable::diff(Building &b, int64_t nowMs, std::string &out) {
+  char head[96];
+  snprintf(head, sizeof(head), "{\"time\":%lld,\"rooms\":{",
+           (long long)nowMs);
+  out = head;
+  for (size_t i = 0; i < b.dirtyRooms.size(); i++) {
+    RoomRecord &r = table[b.dirtyRooms[i]];
+    if (i) {
+      out += ',';
+    }
+    appendRoom(out, b.dirtyRooms[i], r.dirty, false);
+    r.dirty = 0;
+    r.queued = 0;
+  }
+  out += "}}";
+  b.dirtyRooms.clear();
+}
+
+size_t RoomTable::flush(int64_t nowMs, const PublishHandler &publish) {
+  size_t sent = 0;
+  size_t keep = 0;
+  checkOffline(nowMs);
+
+  for (size_t i = 0; i < pendingBuildings.size(); i++) {
+    uint16_t bi = pendingBuildings[i];
+    Building &b = buildingList[bi];
+    if (nowMs - b.lastPublish < periodMs) {
+      pendingBuildings[keep++] = bi; // Coalesce until the period is over
+      continue;
+    }
+    b.lastPublish = nowMs;
+    b.changedSinceSnapshot = true;
+
+    if (diffs) {
+      diff(b, nowMs, json);
+      publish(b.topic + "/diff", json, false);
+      sent++;
+    } else {
+      for (uint32_t room : b.dirtyRooms) {
+        table[room].dirty = 0;
+        table[room].queued = 0;
+      }
+      b.dirtyRooms.clear();
+    }
+  }
+  pendingBuildings.resize(keep);
+
+  // Retained snapshots: every period in snapshot mode, rarely with diffs
+  int64_t every = diffs ? BRIDGE_SNAPSHOT_EVERY_MS : 0;
+  for (size_t bi = 0; bi < buildingList.size(); bi++) {
+    Building &b = buildingList[bi];
+    if (b.changedSinceSnapshot && nowMs - b.lastSnapshot >= every) {
+      snapshot(bi, nowMs, json);
+      publish(b.topic, json, true);
+      b.lastSnapshot = nowMs;
+      b.changedSinceSnapshot = false;
+      sent++;
+    }
+  }
+  return sent;
+}
+
+size_t RoomTable::rooms() const { return table.size(); }
+
+size_t RoomTable::buildings() const { return buildingList.size(); }
+
+uint64_t RoomTable::changes() const { return changed; }
+
+uint64_t RoomTable::unchanged() const { return absorbed; }
@@ -0,0 +1,240 @@
+/**
+ * @file RoomTable.hpp
+ * @brief Room-State Table with Rate-Limited, Coalesced Building Summaries
+ *
+ * Every node publishes each reading on its own topic, so a dashboard that
+ * subscribes to the raw topics wakes up once per reading per room. This
+ * module keeps the latest state of every room in memory and turns the
+ * stream of per-topic updates into at most one message per building per
+ * period:
+ * - diff mode (default): only the rooms and fields that changed, plus a
+ *   retained snapshot every BRIDGE_SNAPSHOT_EVERY_MS for late joiners
+ * - snapshot mode: the full state of the building, retained, so a dashboard
+ *   that connects later gets it at once, at many times the bytes of diffs
+ *
+ * Updates that do not change a value (the door reported closed again) are
+ * absorbed and never reach the dashboards.
+ *
+ * Every message from a room marks it @c "online":true. A room silent for
+ * BRIDGE_OFFLINE_MS turns @c "online":false, and snapshots carry the time
+ * each room was last heard from as @c "seen".
+ *
+ * Topics map to rooms as @c <building>/<room>/<metric>. A missing level
+ * defaults to BRIDGE_DEFAULT_NAME, so the bare firmware topics (@c Lx,
+ * @c esp32/status) form one room.
+ *
+ * Room records are one cache line each and stored contiguously; names and
+ * per-building bookkeeping live in separate, colder arrays.
+ */
+
+#ifndef ROOM_TABLE_H
+#define ROOM_TABLE_H
+
+#include "CampusTopics.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @defgroup RoomTable_Config Room Table Configuration Constants
+ * @{
+ */
+
+/** @brief Default minimum time between two messages for one building */
+#define BRIDGE_PERIOD_MS 1000
+
+/** @brief Retained snapshot interval in diff mode */
+#define BRIDGE_SNAPSHOT_EVERY_MS 60000
+
+/** @brief Default summary topic prefix: @c campus/rooms/<building> */
+#define BRIDGE_TOPIC_PREFIX "campus/rooms"
+
+/** @brief Building or room name used when a topic level is missing */
+#define BRIDGE_DEFAULT_NAME "default"
+
+/**
+ * @brief Silence after which a room is reported offline
+ *
+ * Three times SAMPLE_BASE_INTERVAL_MS: even a quiet room publishes its
+ * readings once a minute.
+ */
+#define BRIDGE_OFFLINE_MS 180000
+
+/** @brief How often flush() looks for rooms that went silent */
+#define BRIDGE_OFFLINE_CHECK_MS 1000
+
+/** @} */
+
+/**
+ * @brief Readings kept per room: every ::CampusMetric, then the status
+ */
+enum RoomField {
+  FIELD_DOOR = METRIC_DOOR,               ///< Door: closed/open
+  FIELD_LUX = METRIC_LUX,                 ///< Lx
+  FIELD_TEMPERATURE = METRIC_TEMPERATURE, ///< Temperature
+  FIELD_HUMIDITY = METRIC_HUMIDITY,       ///< Humidity
+  FIELD_FELT = METRIC_FELT,               ///< FeltTemperature
+  FIELD_PRESSURE = METRIC_PRESSURE,       ///< Pressure
+  FIELD_MOTION = METRIC_MOTION,           ///< Motion: none/stationary/moving
+  FIELD_OCCUPANCY = METRIC_OCCUPANCY,     ///< Occupancy
+  FIELD_ONLINE = METRIC_COUNT,            ///< Heard from lately: 1
+  FIELD_COUNT
+};
+
+/**
+ * @brief Latest state of one room, one cache line
+ */
+struct alignas(64) RoomRecord {
+  /** @brief Latest value per RoomField */
+  float value[FIELD_COUNT];
+
+  /** @brief Time of the last message from the room, ms */
+  int64_t lastSeen;
+
+  /** @brief Bit f set once field f has a value */
+  uint16_t present;
+
+  /** @brief Bit f set if field f changed since the last diff */
+  uint16_t dirty;
+
+  /** @brief Index of the room's building */
+  uint16_t building;
+
+  /** @brief Room is in its building's dirty list */
+  uint8_t queued;
+};
+
+/**
+ * @class RoomTable
+ * @brief In-memory room states and the summary publishing policy
+ */
+class RoomTable {
+public:
+  /**
+   * @brief Callback publishing one summary
+   *
+   * @param topic Summary topic
+   * @param json Message body
+   * @param retain Publish as retained message
+   */
+  using PublishHandler = std::function<void(
+      const std::string &topic, const std::string &json, bool retain)>;
+
+  /**
+   * @param[in] periodMs Minimum time between two messages per building
+   * @param[in] diffs Publish diffs instead of full snapshots
+   * @param[in] prefix Summary topic prefix
+   */
+  explicit RoomTable(int periodMs = BRIDGE_PERIOD_MS, bool diffs = true,
+                     const std::string &prefix = BRIDGE_TOPIC_PREFIX);
+
+  /**
+   * @brief Apply one incoming message
+   *
+   * Messages on the table's own summary topics, unknown metrics and
+   * unparsable payloads are ignored.
+   *
+   * @return @c true if the room state changed
+   */
+  bool update(const char *topic, size_t topicLen, const uint8_t *payload,
+              size_t payloadLen, int64_t nowMs);
+
+  /**
+   * @brief Publish the buildings whose period has elapsed
+   *
+   * Call as often as convenient; each building is published at most once
+   * per period and only if something changed. Also marks rooms silent for
+   * BRIDGE_OFFLINE_MS offline.
+   *
+   * @return Number of messages published
+   */
+  size_t flush(int64_t nowMs, const PublishHandler &publish);
+
+  /** @brief Full state of building @p b as JSON, with last-seen times */
+  void snapshot(size_t b, int64_t nowMs, std::string &out) const;
+
+  /** @brief Number of rooms */
+  size_t rooms() const;
+
+  /** @brief Number of buildings */
+  size_t buildings() const;
+
+  /** @brief Messages that changed a room */
+  uint64_t changes() const;
+
+  /** @brief Messages absorbed because nothing changed */
+  uint64_t unchanged() const;
+
+private:
+  struct Building {
+    std::string name;
+    std::string topic;
+    std::vector<uint32_t> rooms;
+    std::vector<uint32_t> dirtyRooms;
+    int64_t lastPublish;
+    int64_t lastSnapshot;
+    bool changedSinceSnapshot;
+  };
+
+  int periodMs;
+  bool diffs;
+  std::string prefix;
+
+  /** @brief Hot data: one record per room */
+  std::vector<RoomRecord> table;
+
+  /** @brief Cold data: quoted JSON room names, same index as @ref table */
+  std::vector<std::string> roomNames;
+
+  std::vector<Building> buildingList;
+
+  /** @brief Buildings with unpublished changes */
+  std::vector<uint16_t> pendingBuildings;
+
+  std::unordered_map<std::string, uint16_t> buildingIndex;
+  std::unordered_map<std::string, uint32_t> roomIndex;
+
+  /** @brief Topic to (room << 8 | field), or UINT64_MAX if ignored */
+  std::unordered_map<std::string, uint64_t> topics;
+
+  /** @brief Topic scratch buffer for @ref topics lookups */
+  std::string key;
+
+  /** @brief JSON scratch buffer */
+  std::string json;
+
+  uint64_t changed;
+  uint64_t absorbed;
+  int64_t lastOfflineCheck;
+
+  /** @brief Resolve an uncached topic to (room << 8 | field) */
+  uint64_t resolve(const std::string &topic);
+
+  /**
+   * @brief Set a field, marking the room dirty and queueing it
+   *
+   * @return @c false if the field already had this value
+   */
+  bool set(uint32_t room, RoomField field, float value);
+
+  /** @brief Mark rooms silent for BRIDGE_OFFLINE_MS offline */
+  void checkOffline(int64_t nowMs);
+
+  /** @brief Changed rooms of building @p b as JSON, clearing dirty bits */
+  void diff(Building &b, int64_t nowMs, std::string &out);
+
+  /**
+   * @brief Append one room object to @p out
+   *
+   * @param[in] fields Bit mask of the RoomField values to include
+   * @param[in] seen Include the last-seen time
+   */
+  void appendRoom(std::string &out, uint32_t room, uint16_t fields,
+                  bool seen) const;
+};
+
+#endif // ROOM_TABLE_H
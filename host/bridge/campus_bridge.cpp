@@ -0,0 +1,159 @@
+/*
+        Smart Campus room-state bridge
+
+        Subscribes to the node topics (sensorTopicFilters() unless
+        --topic is given, so never to its own output) and keeps
+        the latest state of every room in a RoomTable. At most once per period per
+        building it publishes the changed rooms and fields on
+        campus/rooms/<building>/diff, plus a retained full
+        snapshot on campus/rooms/<building> every minute. With
+        --snapshots it publishes only the retained snapshot,
+        every period; simpler for dashboards but many times the
+        bytes.
+        Rooms silent for three minutes are published as offline.
+        Dashboards subscribe to campus/rooms/# over MQTT or the
+        broker's WebSocket listener instead of the raw topics.
+        Reconnects forever, so it can start before the broker.
+
+        Usage:
+          campus_bridge [--broker HOST:PORT] [--topic FILTER]...
+                        [--period MS] [--diff|--snapshots]
+                        [--prefix TOPIC]
+                        [--stats SECONDS]
+*/
+
+#include "CampusTopics.hpp"
+#include "MqttClient.hpp"
+#include "RoomTable.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#define RECONNECT_DELAY_S 2
+
+// Longest wait for messages before checking the building periods
+#define POLL_MS 20
+
+struct Options {
+  std::string brokerHost = "127.0.0.1";
+  uint16_t brokerPort = 1883;
+  std::vector<std::string> topics;
+  int periodMs = BRIDGE_PERIOD_MS;
+  bool diffs = true;
+  std::string prefix = BRIDGE_TOPIC_PREFIX;
+  int statsSeconds = 60;
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int) { stopping = 1; }
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--broker") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.brokerHost, opt.brokerPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--topic") && hasValue) {
+      opt.topics.push_back(argv[++i]);
+    } else if (!strcmp(argv[i], "--period") && hasValue) {
+      opt.periodMs = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--diff")) {
+      opt.diffs = true;
+    } else if (!strcmp(argv[i], "--snapshots")) {
+      opt.diffs = false;
+    } else if (!strcmp(argv[i], "--prefix") && hasValue) {
+      opt.prefix = argv[++i];
+    } else if (!strcmp(argv[i], "--stats") && hasValue) {
+      opt.statsSeconds = atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  if (opt.topics.empty()) {
+    opt.topics = sensorTopicFilters();
+  }
+  return opt.periodMs >= 0 && opt.statsSeconds > 0 && !opt.prefix.empty();
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    fprintf(stderr,
+            "usage: %s [--broker HOST:PORT] [--topic FILTER]... "
+            "[--period MS] [--diff|--snapshots] [--prefix TOPIC] "
+            "[--stats SECONDS]\n",
+            argv[0]);
+    return 2;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  RoomTable rooms(opt.periodMs, opt.diffs, opt.prefix);
+  uint64_t received = 0, sent = 0;
+
+  MqttClient client;
+  MqttClient::MessageHandler onMessage = [&](const char *topic,
+                                             size_t topicLen,
+                                             const uint8_t *payload,
+                                             size_t payloadLen) {
+    rooms.update(topic, topicLen, payload, payloadLen, realtimeMs());
+    received++;
+  };
+  RoomTable::PublishHandler publish = [&](const std::string &topic,
+                                          const std::string &json,
+                                          bool retain) {
+    client.publish(topic, json.data(), json.size(), retain);
+  };
+
+  int64_t nextStats = monotonicMs() + opt.statsSeconds * 1000LL;
+  uint64_t lastReceived = 0, lastSent = 0;
+
+  while (!stopping) {
+    if (!client.connected()) {
+      bool ok = client.connect(opt.brokerHost, opt.brokerPort,
+                               "campus-bridge-" + std::to_string(getpid()));
+      for (size_t i = 0; ok && i < opt.topics.size(); i++) {
+        ok = client.subscribe(opt.topics[i]);
+      }
+      if (!ok) {
+        fprintf(stderr, "bridge: broker %s:%u unavailable, retrying\n",
+                opt.brokerHost.c_str(), opt.brokerPort);
+        client.disconnect();
+        sleep(RECONNECT_DELAY_S);
+        continue;
+      }
+      printf("bridge: connected to %s:%u, publishing %s on %s/<building>\n",
+             opt.brokerHost.c_str(), opt.brokerPort,
+             opt.diffs ? "diffs" : "snapshots", opt.prefix.c_str());
+      fflush(stdout);
+    }
+
+    client.poll(POLL_MS, onMessage);
+    sent += rooms.flush(realtimeMs(), publish);
+
+    int64_t now = monotonicMs();
+    if (now >= nextStats) {
+      printf("bridge: %.0f msg/s in, %.1f msg/s out, %zu rooms in %zu "
+             "buildings, %llu changes, %llu unchanged\n",
+             (double)(received - lastReceived) / opt.statsSeconds,
+             (double)(sent - lastSent) / opt.statsSeconds, rooms.rooms(),
+             rooms.buildings(), (unsigned long long)rooms.changes(),
+             (unsigned long long)rooms.unchanged());
+      fflush(stdout);
+      lastReceived = received;
+      lastSent = sent;
+      nextStats = now + opt.statsSeconds * 1000LL;
+    }
+  }
+
+  client.disconnect();
+  printf("bridge: stopped\n");
+  return 0;
+}
@@ -0,0 +1,92 @@
+#include "CampusTopics.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+// Topic names published by src/main.cpp, by CampusMetric
+const char *const campusMetricNames[METRIC_COUNT] = {
+    "Door",     "Lx",     "Temperature", "Humidity", "FeltTemperature",
+    "Pressure", "Motion", "Occupancy"};
+
+static const char *const doorText[] = {"Closed", "Open"};
+static const char *const motionText[] = {"none", "stationary", "moving"};
+
+// Text states of a metric, value i named names[i]
+static int textStates(int metric, const char *const *&names) {
+  if (metric == METRIC_DOOR) {
+    names = doorText;
+    return 2;
+  }
+  if (metric == METRIC_MOTION) {
+    names = motionText;
+    return 3;
+  }
+  names = nullptr;
+  return 0;
+}
+
+int campusMetric(const char *name, size_t len) {
+  for (int m = 0; m < METRIC_COUNT; m++) {
+    if (strlen(campusMetricNames[m]) == len &&
+        memcmp(campusMetricNames[m], name, len) == 0) {
+      return m;
+    }
+  }
+  return -1;
+}
+
+bool parseReading(int metric, const uint8_t *payload, size_t len,
+                  double &value) {
+  char text[32];
+  if (len == 0 || len >= sizeof(text)) {
+    return false;
+  }
+  memcpy(text, payload, len);
+  text[len] = '\0';
+
+  const char *const *names;
+  int count = textStates(metric, names);
+  for (int i = 0; i < count; i++) {
+    if (strcmp(text, names[i]) == 0) {
+      value = i;
+      return true;
+    }
+  }
+
+  char *end;
+  value = strtod(text, &end);
+  if (end == text) {
+    return false;
+  }
+  while (*end == ' ' || *end == '\r' || *end == '\n') {
+    end++;
+  }
+  return *end == '\0' && std::isfinite(value);
+}
+
+const char *readingText(int metric, double value) {
+  const char *const *names;
+  int count = textStates(metric, names);
+  if (count == 0) {
+    return nullptr;
+  }
+  // Door: anything but 0 is open; Motion: out of range reads as none
+  if (metric == METRIC_DOOR) {
+    return names[value != 0];
+  }
+  return names[value >= 0 && value < count ? (int)value : 0];
+}
+
+std::vector<std::string> sensorTopicFilters() {
+  std::vector<std::string> filters;
+  std::string prefix;
+  for (int depth = 0; depth <= CAMPUS_TOPIC_MAX_DEPTH; depth++) {
+    for (const char *metric : campusMetricNames) {
+      filters.push_back(prefix + metric);
+    }
+    filters.push_back(prefix + CAMPUS_STATUS_TOPIC);
+    prefix += "+/";
+  }
+  return filters;
+}
@@ -0,0 +1,92 @@
+/**
+ * @file CampusTopics.hpp
+ * @brief Topics and Payloads Published by the Sensor Nodes
+ *
+ * What src/main.cpp publishes, for the host services that consume it:
+ * - one topic per reading, @c [<node prefix>/]<metric>, with the metrics
+ *   listed in ::CampusMetric, plus @c esp32/status and @c Alert;
+ * - payloads as text: numbers, except the states of @c Door (Closed/Open)
+ *   and @c Motion (none/stationary/moving), which parseReading() maps to
+ *   0/1 and 0/1/2 and readingText() maps back.
+ *
+ * MQTT wildcards cannot match on the last level, so sensorTopicFilters()
+ * spells out every metric at each prefix depth up to CAMPUS_TOPIC_MAX_DEPTH.
+ * Subscribing to those instead of @c # keeps the services from receiving
+ * each other's output, or their own.
+ */
+
+#ifndef CAMPUS_TOPICS_H
+#define CAMPUS_TOPICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @defgroup CampusTopics_Config Campus Topic Constants
+ * @{
+ */
+
+/** @brief Deepest node prefix covered by sensorTopicFilters() */
+#define CAMPUS_TOPIC_MAX_DEPTH 4
+
+/** @brief Connection status topic; counts as one level */
+#define CAMPUS_STATUS_TOPIC "esp32/status"
+
+/** @} */
+
+/**
+ * @brief Readings published by a node
+ */
+enum CampusMetric {
+  METRIC_DOOR,        ///< Door: 0 closed, 1 open
+  METRIC_LUX,         ///< Lx
+  METRIC_TEMPERATURE, ///< Temperature
+  METRIC_HUMIDITY,    ///< Humidity
+  METRIC_FELT,        ///< FeltTemperature
+  METRIC_PRESSURE,    ///< Pressure
+  METRIC_MOTION,      ///< Motion: 0 none, 1 stationary, 2 moving
+  METRIC_OCCUPANCY,   ///< Occupancy
+  METRIC_COUNT
+};
+
+/** @brief Topic level of each ::CampusMetric */
+extern const char *const campusMetricNames[METRIC_COUNT];
+
+/**
+ * @brief Look up a metric by its topic level
+ *
+ * @return ::CampusMetric, or -1 for anything else (status, alerts, ...)
+ */
+int campusMetric(const char *name, size_t len);
+
+/**
+ * @brief Parse a reading's payload
+ *
+ * Accepts finite numbers, optionally followed by whitespace, and for Door
+ * and Motion their text states.
+ *
+ * @param[in] metric ::CampusMetric the payload was published on
+ *
+ * @return @c false for any other payload
+ */
+bool parseReading(int metric, const uint8_t *payload, size_t len,
+                  double &value);
+
+/**
+ * @brief Text state of a Door or Motion value
+ *
+ * @return State name, or @c nullptr for metrics published as numbers
+ */
+const char *readingText(int metric, double value);
+
+/**
+ * @brief Topic filters matching every reading and the status topic
+ *
+ * @c Lx, @c +/Lx, @c +/+/Lx, ... for each metric, up to
+ * CAMPUS_TOPIC_MAX_DEPTH prefix levels.
+ */
+std::vector<std::string> sensorTopicFilters();
+
+#endif // CAMPUS_TOPICS_H
@@ -0,0 +1,123 @@
+#include "CampusTraffic.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+// Mean seconds between Door/Motion changes, and sampler interval bounds
+#define EVENT_MEAN_S 300
+#define FAST_INTERVAL_S 2
+#define SLOW_INTERVAL_S 60
+
+static const CampusMetric trafficMetrics[TRAFFIC_METRICS] = {
+    METRIC_DOOR,     METRIC_LUX,  METRIC_TEMPERATURE,
+    METRIC_HUMIDITY, METRIC_FELT, METRIC_MOTION};
+
+CampusTraffic::CampusTraffic(int rooms, int64_t startMs, uint32_t seed)
+    : nodes(rooms), rng(seed) {
+  for (Node &n : nodes) {
+    for (int m = 0; m < TRAFFIC_METRICS; m++) {
+      n.due[m] = startMs + (int64_t)(rng.next() % 60000);
+    }
+    n.lux = 300.0f * rng.uniform();
+    n.temperature = 19.0f + 4.0f * rng.uniform();
+    n.humidity = 40.0f + 15.0f * rng.uniform();
+    n.door = false;
+    n.motion = 0;
+  }
+}
+
+int64_t CampusTraffic::eventGap() {
+  return (int64_t)(rng.uniform() * 2 * EVENT_MEAN_S * 1000);
+}
+
+int64_t CampusTraffic::interval(bool active) {
+  int64_t s = active ? FAST_INTERVAL_S
+                     : FAST_INTERVAL_S +
+                           (int64_t)(rng.uniform() *
+                                     (SLOW_INTERVAL_S - FAST_INTERVAL_S));
+  return s * 1000 + (int64_t)(rng.next() % 1000);
+}
+
+void CampusTraffic::emit(std::vector<TrafficMessage> &out, uint32_t topic,
+                         int64_t time, const char *fmt, double value) {
+  TrafficMessage m;
+  m.topic = topic;
+  m.time = time;
+  m.len = (uint8_t)snprintf(m.payload, sizeof(m.payload), fmt, value);
+  out.push_back(m);
+}
+
+static void emitText(std::vector<TrafficMessage> &out, uint32_t topic,
+                     int64_t time, const char *text) {
+  TrafficMessage m;
+  m.topic = topic;
+  m.time = time;
+  m.len = (uint8_t)snprintf(m.payload, sizeof(m.payload), "%s", text);
+  out.push_back(m);
+}
+
+void CampusTraffic::generate(int64_t t, std::vector<TrafficMessage> &out) {
+  static const char *motionText[] = {"none", "stationary", "moving"};
+  out.clear();
+  for (size_t n = 0; n < nodes.size(); n++) {
+    Node &node = nodes[n];
+    uint32_t topic = (uint32_t)(n * TRAFFIC_METRICS);
+    for (int m = 0; m < TRAFFIC_METRICS; m++) {
+      int64_t when = node.due[m];
+      if (when >= t + 1000) {
+        continue;
+      }
+      bool active = rng.uniform() < 0.2f;
+      switch (m) {
+      case TRAFFIC_DOOR:
+        node.door = !node.door;
+        emitText(out, topic + m, when, node.door ? "Open" : "Closed");
+        node.due[m] = when + eventGap();
+        continue;
+      case TRAFFIC_MOTION:
+        node.motion = (int)(rng.next() % 3);
+        emitText(out, topic + m, when, motionText[node.motion]);
+        node.due[m] = when + eventGap();
+        continue;
+      case TRAFFIC_LUX:
+        node.lux = std::max(0.0f, node.lux + (active ? 120.0f : 3.0f) *
+                                                 (rng.uniform() * 2 - 1));
+        emit(out, topic + m, when, "%.0f", node.lux);
+        break;
+      case TRAFFIC_TEMPERATURE:
+        node.temperature += (active ? 0.5f : 0.05f) * (rng.uniform() * 2 - 1);
+        emit(out, topic + m, when, "%.2f", node.temperature);
+        break;
+      case TRAFFIC_HUMIDITY:
+        node.humidity += (active ? 2.0f : 0.2f) * (rng.uniform() * 2 - 1);
+        emit(out, topic + m, when, "%.2f", node.humidity);
+        break;
+      case TRAFFIC_FELT:
+        emit(out, topic + m, when, "%.2f",
+             node.temperature + 0.05f * (node.humidity - 40.0f));
+        break;
+      }
+      node.due[m] = when + interval(active);
+    }
+  }
+  std::sort(out.begin(), out.end(),
+            [](const TrafficMessage &a, const TrafficMessage &b) {
+              return a.time < b.time;
+            });
+}
+
+std::vector<std::string> CampusTraffic::topics(int rooms,
+                                               int roomsPerBuilding,
+                                               const char *root) {
+  std::vector<std::string> names;
+  for (int n = 0; n < rooms; n++) {
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "%sbldg-%d/room-%03d/", root,
+             n / roomsPerBuilding, n % roomsPerBuilding);
+    for (int m = 0; m < TRAFFIC_METRICS; m++) {
+      names.push_back(std::string(prefix) +
+                      campusMetricNames[trafficMetrics[m]]);
+    }
+  }
+  return names;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file CampusTraffic.hpp
+ * @brief Synthetic Sensor Traffic for the Host Benchmarks
+ *
+ * A campus of rooms, one node each, publishing what src/main.cpp publishes
+ * (Door, Lx, Temperature, Humidity, FeltTemperature, Motion) at
+ * adaptive-sampling rates: readings every 2 s while a value moves and up to
+ * every 60 s while it is quiet, door and motion changes every 5 minutes on
+ * average. Values random-walk around classroom levels and payloads are
+ * formatted as the firmware formats them, so they repeat when a change is
+ * below the printed precision, as they do on the boards.
+ *
+ * The stream is deterministic: the same room count, start and seed give the
+ * same messages, so ingest_bench and bridge_bench runs are comparable.
+ */
+
+#ifndef CAMPUS_TRAFFIC_H
+#define CAMPUS_TRAFFIC_H
+
+#include "CampusTopics.hpp"
+#include "Xorshift.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Metrics each simulated node publishes, in topic index order
+ */
+enum TrafficMetric {
+  TRAFFIC_DOOR,
+  TRAFFIC_LUX,
+  TRAFFIC_TEMPERATURE,
+  TRAFFIC_HUMIDITY,
+  TRAFFIC_FELT,
+  TRAFFIC_MOTION,
+  TRAFFIC_METRICS
+};
+
+/**
+ * @brief One simulated publish
+ */
+struct TrafficMessage {
+  uint32_t topic; ///< Room * TRAFFIC_METRICS + ::TrafficMetric
+  int64_t time;   ///< Publish time (ms)
+  uint8_t len;    ///< Payload length
+  char payload[15];
+};
+
+/**
+ * @class CampusTraffic
+ * @brief Generator of the messages a campus publishes, second by second
+ */
+class CampusTraffic {
+public:
+  /**
+   * @param[in] rooms Number of rooms (nodes)
+   * @param[in] startMs Time of the first readings (ms)
+   * @param[in] seed Generator seed
+   */
+  CampusTraffic(int rooms, int64_t startMs, uint32_t seed = 1013904223u);
+
+  /**
+   * @brief Messages due in [t, t + 1 s), sorted by time
+   *
+   * @param[in] t Start of the second (ms); call with consecutive seconds
+   * @param[out] out Replaced with the messages
+   */
+  void generate(int64_t t, std::vector<TrafficMessage> &out);
+
+  /**
+   * @brief Topic names by TrafficMessage::topic
+   *
+   * @c <root>bldg-<b>/room-<rrr>/<metric>, @p roomsPerBuilding rooms per
+   * building.
+   */
+  static std::vector<std::string> topics(int rooms, int roomsPerBuilding,
+                                         const char *root = "");
+
+  /**
+   * @brief Append a message with a numeric payload formatted by @p fmt
+   */
+  static void emit(std::vector<TrafficMessage> &out, uint32_t topic,
+                   int64_t time, const char *fmt, double value);
+
+private:
+  struct Node {
+    int64_t due[TRAFFIC_METRICS];
+    float lux, temperature, humidity;
+    bool door;
+    int motion;
+  };
+
+  std::vector<Node> nodes;
+  Xorshift rng;
+
+  /** @brief Interval after a reading: fast while it moves, slow otherwise */
+  int64_t interval(bool active);
+
+  /** @brief Time to the next Door or Motion change */
+  int64_t eventGap();
+};
+
+#endif // CAMPUS_TRAFFIC_H
@@ -0,0 +1,323 @@
+#include "MqttClient.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// MQTT 3.1.1 control packet types (upper nibble of the fixed header)
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_SUBSCRIBE 0x82
+#define MQTT_SUBACK 0x90
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// How long connect()/subscribe() wait for the broker's acknowledgement
+#define MQTT_ACK_TIMEOUT_MS 5000
+
+int64_t monotonicNs() {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+int64_t monotonicMs() { return monotonicNs() / 1000000; }
+
+int64_t realtimeMs() {
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+bool splitHostPort(const char *arg, std::string &host, uint16_t &port) {
+  const char *colon = strrchr(arg, ':');
+  if (!colon) {
+    host = arg;
+    return !host.empty();
+  }
+  char *end;
+  long p = strtol(colon + 1, &end, 10);
+  if (end == colon + 1 || *end != '\0' || p < 1 || p > 65535) {
+    return false;
+  }
+  host.assign(arg, (size_t)(colon - arg));
+  port = (uint16_t)p;
+  return !host.empty();
+}
+
+static void putRemainingLength(std::vector<uint8_t> &out, size_t len) {
+  do {
+    uint8_t b = len % 128;
+    len /= 128;
+    if (len > 0) {
+      b |= 0x80;
+    }
+    out.push_back(b);
+  } while (len > 0);
+}
+
+static void putString(std::vector<uint8_t> &out, const std::string &s) {
+  out.push_back((uint8_t)(s.size() >> 8));
+  out.push_back((uint8_t)(s.size() & 0xFF));
+  out.insert(out.end(), s.begin(), s.end());
+}
+
+MqttClient::MqttClient()
+    : fd(-1), keepAliveMs(0), lastSend(0), nextPacketId(1), sent(0),
+      received(0) {}
+
+MqttClient::~MqttClient() { disconnect(); }
+
+bool MqttClient::connect(const std::string &host, uint16_t port,
+                         const std::string &clientId, uint16_t keepAlive) {
+  disconnect();
+
+  addrinfo hints{};
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo *res = nullptr;
+  if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) !=
+      0) {
+    return false;
+  }
+  for (addrinfo *ai = res; ai; ai = ai->ai_next) {
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Small packets are the norm; do not let Nagle batch them
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  std::vector<uint8_t> body;
+  putString(body, "MQTT");
+  body.push_back(0x04); // Protocol level 3.1.1
+  body.push_back(0x02); // Clean session
+  body.push_back((uint8_t)(keepAlive >> 8));
+  body.push_back((uint8_t)(keepAlive & 0xFF));
+  putString(body, clientId);
+
+  tx.clear();
+  tx.push_back(MQTT_CONNECT);
+  putRemainingLength(tx, body.size());
+  tx.insert(tx.end(), body.begin(), body.end());
+
+  keepAliveMs = (int64_t)keepAlive * 1000;
+  if (!flush() || !waitFor(MQTT_CONNACK, MQTT_ACK_TIMEOUT_MS)) {
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+bool MqttClient::subscribe(const std::string &filter) {
+  uint16_t id = nextPacketId++;
+  if (nextPacketId == 0) {
+    nextPacketId = 1;
+  }
+
+  tx.clear();
+  tx.push_back(MQTT_SUBSCRIBE);
+  putRemainingLength(tx, 2 + 2 + filter.size() + 1);
+  tx.push_back((uint8_t)(id >> 8));
+  tx.push_back((uint8_t)(id & 0xFF));
+  putString(tx, filter);
+  tx.push_back(0x00); // Requested QoS
+
+  return flush() && waitFor(MQTT_SUBACK, MQTT_ACK_TIMEOUT_MS);
+}
+
+void MqttClient::encodePublish(std::vector<uint8_t> &out,
+                               const std::string &topic, const void *payload,
+                               size_t len, bool retain) {
+  out.clear();
+  out.push_back(MQTT_PUBLISH | (retain ? 0x01 : 0x00));
+  putRemainingLength(out, 2 + topic.size() + len);
+  putString(out, topic);
+  const uint8_t *p = static_cast<const uint8_t *>(payload);
+  out.insert(out.end(), p, p + len);
+}
+
+bool MqttClient::publish(const std::string &topic, const void *payload,
+                         size_t len, bool retain) {
+  encodePublish(tx, topic, payload, len, retain);
+  return flush();
+}
+
+bool MqttClient::publish(const std::string &topic, const char *payload,
+                         bool retain) {
+  return publish(topic, payload, strlen(payload), retain);
+}
+
+bool MqttClient::flush() {
+  if (fd < 0) {
+    return false;
+  }
+  size_t off = 0;
+  while (off < tx.size()) {
+    ssize_t n = send(fd, tx.data() + off, tx.size() - off, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // Not disconnect(): it would queue a DISCONNECT and flush again
+      close(fd);
+      fd = -1;
+      rx.clear();
+      return false;
+    }
+    off += (size_t)n;
+  }
+  sent += tx.size();
+  lastSend = monotonicMs();
+  return true;
+}
+
+bool MqttClient::fill(int timeoutMs) {
+  pollfd pfd{fd, POLLIN, 0};
+  int r = ::poll(&pfd, 1, timeoutMs);
+  if (r < 0) {
+    return errno == EINTR;
+  }
+  if (r == 0) {
+    return true;
+  }
+
+  uint8_t chunk[16384];
+  ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+  if (n <= 0) {
+    close(fd);
+    fd = -1;
+    return false;
+  }
+  rx.insert(rx.end(), chunk, chunk + n);
+  received += (uint64_t)n;
+  return true;
+}
+
+bool MqttClient::nextPacket(size_t pos, uint8_t &type, size_t &body,
+                            size_t &bodyLen) const {
+  // Fixed header: type byte, then 1-4 bytes of remaining length
+  size_t len = 0;
+  size_t mult = 1;
+  size_t i = pos + 1;
+  for (;; i++) {
+    if (i >= rx.size() || i > pos + 4) {
+      return false;
+    }
+    len += (rx[i] & 0x7F) * mult;
+    mult *= 128;
+    if (!(rx[i] & 0x80)) {
+      break;
+    }
+  }
+  if (rx.size() < i + 1 + len) {
+    return false;
+  }
+  type = rx[pos];
+  body = i + 1;
+  bodyLen = len;
+  return true;
+}
+
+bool MqttClient::waitFor(uint8_t type, int timeoutMs) {
+  int64_t deadline = monotonicMs() + timeoutMs;
+
+  while (fd >= 0) {
+    uint8_t t;
+    size_t body, bodyLen;
+    while (nextPacket(0, t, body, bodyLen)) {
+      bool match = (t & 0xF0) == (type & 0xF0);
+      bool ok = bodyLen >= 1;
+      if (match && type == MQTT_CONNACK) {
+        ok = bodyLen >= 2 && rx[body + 1] == 0x00; // Return code
+      } else if (match && type == MQTT_SUBACK) {
+        ok = bodyLen >= 3 && rx[body + 2] != 0x80; // Granted QoS
+      }
+      rx.erase(rx.begin(), rx.begin() + body + bodyLen);
+      if (match) {
+        return ok;
+      }
+    }
+    int64_t left = deadline - monotonicMs();
+    if (left <= 0 || !fill((int)left)) {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool MqttClient::poll(int timeoutMs, const MessageHandler &onMessage) {
+  if (fd < 0) {
+    return false;
+  }
+  if (keepAliveMs > 0 && monotonicMs() - lastSend >= keepAliveMs / 2) {
+    tx.assign({MQTT_PINGREQ, 0x00});
+    if (!flush()) {
+      return false;
+    }
+  }
+  if (!fill(timeoutMs)) {
+    return false;
+  }
+
+  // Dispatch every complete packet, then drop them from the buffer at once
+  size_t pos = 0;
+  uint8_t t;
+  size_t body, len;
+  while (nextPacket(pos, t, body, len)) {
+    const uint8_t *p = rx.data() + body;
+    if ((t & 0xF0) == MQTT_PUBLISH && len >= 2) {
+      size_t topicLen = (size_t)((p[0] << 8) | p[1]);
+      size_t skip = 2 + topicLen;
+      if (t & 0x06) {
+        skip += 2; // Packet identifier for QoS > 0
+      }
+      if (skip <= len && onMessage) {
+        onMessage(reinterpret_cast<const char *>(p + 2), topicLen, p + skip,
+                  len - skip);
+      }
+    }
+    pos = body + len;
+  }
+  rx.erase(rx.begin(), rx.begin() + pos);
+  return fd >= 0;
+}
+
+void MqttClient::disconnect() {
+  if (fd >= 0) {
+    tx.assign({MQTT_DISCONNECT, 0x00});
+    flush();
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  fd = -1;
+  rx.clear();
+}
+
+bool MqttClient::connected() const { return fd >= 0; }
+
+uint64_t MqttClient::bytesSent() const { return sent; }
+
+uint64_t MqttClient::bytesReceived() const { return received; }
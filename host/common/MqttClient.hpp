@@ -0,0 +1,192 @@
+/**
+ * @file MqttClient.hpp
+ * @brief Minimal Blocking MQTT 3.1.1 Client for Host-Side Tools
+ *
+ * This module implements the small part of MQTT 3.1.1 needed by the native
+ * Smart Campus tools (benchmarks and backend services): CONNECT, SUBSCRIBE,
+ * QoS 0 PUBLISH and keep-alive PINGREQ over a plain POSIX TCP socket.
+ *
+ * It deliberately has no external dependencies so the tools build anywhere a
+ * C++17 compiler is available, including minimal Docker images.
+ *
+ * @note Not thread-safe; use one client per thread
+ * @see https://docs.oasis-open.org/mqtt/mqtt/v3.1.1/mqtt-v3.1.1.html
+ */
+
+#ifndef MQTT_CLIENT_H
+#define MQTT_CLIENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class MqttClient
+ * @brief Blocking MQTT 3.1.1 client over TCP
+ *
+ * Messages received on subscribed topics are delivered through the callback
+ * passed to poll(). Topic and payload views are only valid during the call.
+ */
+class MqttClient {
+public:
+  /**
+   * @brief Callback invoked for each incoming PUBLISH
+   *
+   * @param topic Topic name (not NUL-terminated)
+   * @param topicLen Length of @p topic
+   * @param payload Payload bytes
+   * @param payloadLen Length of @p payload
+   */
+  using MessageHandler =
+      std::function<void(const char *topic, size_t topicLen,
+                         const uint8_t *payload, size_t payloadLen)>;
+
+  MqttClient();
+  ~MqttClient();
+
+  MqttClient(const MqttClient &) = delete;
+  MqttClient &operator=(const MqttClient &) = delete;
+
+  /**
+   * @brief Connect to a broker and wait for CONNACK
+   *
+   * @param[in] host Broker host name or address
+   * @param[in] port Broker TCP port
+   * @param[in] clientId Client identifier
+   * @param[in] keepAlive Keep-alive period in seconds
+   *
+   * @return @c true if the broker accepted the connection
+   */
+  bool connect(const std::string &host, uint16_t port,
+               const std::string &clientId, uint16_t keepAlive = 60);
+
+  /**
+   * @brief Subscribe to a topic filter at QoS 0 and wait for SUBACK
+   *
+   * @return @c true if the broker granted the subscription
+   */
+  bool subscribe(const std::string &filter);
+
+  /**
+   * @brief Publish a QoS 0 message
+   *
+   * @return @c true if the whole packet was written to the socket
+   */
+  bool publish(const std::string &topic, const void *payload, size_t len,
+               bool retain = false);
+
+  /**
+   * @brief Publish a NUL-terminated payload at QoS 0
+   */
+  bool publish(const std::string &topic, const char *payload,
+               bool retain = false);
+
+  /**
+   * @brief Read and dispatch incoming packets
+   *
+   * Waits up to @p timeoutMs for data, then handles every complete packet in
+   * the receive buffer. Also sends PINGREQ when the keep-alive is due.
+   *
+   * @param[in] timeoutMs Maximum time to block, 0 to return immediately
+   * @param[in] onMessage Handler for incoming PUBLISH packets
+   *
+   * @return @c false if the connection was lost
+   */
+  bool poll(int timeoutMs, const MessageHandler &onMessage);
+
+  /**
+   * @brief Send DISCONNECT and close the socket
+   */
+  void disconnect();
+
+  /** @brief @c true while the TCP connection is open */
+  bool connected() const;
+
+  /** @brief Total bytes written to the socket since construction */
+  uint64_t bytesSent() const;
+
+  /** @brief Total bytes read from the socket since construction */
+  uint64_t bytesReceived() const;
+
+  /**
+   * @brief Encode a PUBLISH packet into @p out
+   *
+   * Exposed so benchmarks can measure the exact on-the-wire size without a
+   * broker connection.
+   */
+  static void encodePublish(std::vector<uint8_t> &out, const std::string &topic,
+                            const void *payload, size_t len, bool retain);
+
+private:
+  /** @brief Socket descriptor, -1 when closed */
+  int fd;
+
+  /** @brief Keep-alive period in milliseconds */
+  int64_t keepAliveMs;
+
+  /** @brief Monotonic time (ms) of the last packet sent */
+  int64_t lastSend;
+
+  /** @brief Next packet identifier for SUBSCRIBE */
+  uint16_t nextPacketId;
+
+  /** @brief Bytes received but not yet parsed */
+  std::vector<uint8_t> rx;
+
+  /** @brief Scratch buffer for outgoing packets */
+  std::vector<uint8_t> tx;
+
+  /** @brief Byte counters */
+  uint64_t sent;
+  uint64_t received;
+
+  /** @brief Write all of @ref tx to the socket */
+  bool flush();
+
+  /** @brief Read whatever is available, waiting up to @p timeoutMs */
+  bool fill(int timeoutMs);
+
+  /**
+   * @brief Locate the complete packet starting at @p pos in @ref rx
+   *
+   * @param[in] pos Offset of the fixed header in @ref rx
+   * @param[out] type Fixed-header byte
+   * @param[out] body Offset of the variable header in @ref rx
+   * @param[out] bodyLen Remaining length
+   *
+   * @return @c true if a whole packet is buffered
+   */
+  bool nextPacket(size_t pos, uint8_t &type, size_t &body,
+                  size_t &bodyLen) const;
+
+  /**
+   * @brief Block until a packet of the given type arrives
+   *
+   * PUBLISH packets received meanwhile are discarded.
+   */
+  bool waitFor(uint8_t type, int timeoutMs);
+};
+
+/** @brief Monotonic clock in milliseconds */
+int64_t monotonicMs();
+
+/** @brief Monotonic clock in nanoseconds */
+int64_t monotonicNs();
+
+/** @brief Wall clock in milliseconds since the epoch */
+int64_t realtimeMs();
+
+/**
+ * @brief Parse a @c HOST[:PORT] command-line argument
+ *
+ * @param[in] arg Argument, e.g. @c mosquitto:1883
+ * @param[out] host Host part
+ * @param[in,out] port Port, left unchanged if @p arg has none
+ *
+ * @return @c false if the host is empty or the port is not 1-65535
+ */
+bool splitHostPort(const char *arg, std::string &host, uint16_t &port);
+
+#endif // MQTT_CLIENT_H
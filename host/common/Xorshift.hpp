@@ -0,0 +1,43 @@
+/**
+ * @file Xorshift.hpp
+ * @brief Deterministic Random Numbers for Benchmarks and Simulations
+ *
+ * Marsaglia's xorshift32: one word of state and the same sequence on every
+ * platform, so runs with the same seed are comparable between machines and
+ * between versions of a benchmark.
+ *
+ * @see https://www.jstatsoft.org/article/view/v008i14
+ */
+
+#ifndef XORSHIFT_H
+#define XORSHIFT_H
+
+#include <cstdint>
+
+/**
+ * @class Xorshift
+ * @brief xorshift32 generator
+ */
+class Xorshift {
+public:
+  /**
+   * @param[in] seed Initial state; 0 would repeat forever and is replaced
+   */
+  explicit Xorshift(uint32_t seed = 2463534242u) : state(seed ? seed : 1) {}
+
+  /** @brief Next 32 random bits */
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  /** @brief Uniform in [0, 1), 24 bits of resolution */
+  float uniform() { return (float)(next() & 0xFFFFFF) / 0x1000000; }
+
+private:
+  uint32_t state;
+};
+
+#endif // XORSHIFT_H
@@ -0,0 +1,53 @@
+#include "Ingestor.hpp"
+
+Ingestor::Ingestor(TimeSeriesStore &store, size_t maxTopics)
+    : store(store), maxTopics(maxTopics), stored(0), skipped(0),
+      overLimit(0) {}
+
+bool Ingestor::handle(const char *topic, size_t topicLen,
+                      const uint8_t *payload, size_t payloadLen,
+                      int64_t nowMs) {
+  key.assign(topic, topicLen);
+  auto it = topics.find(key);
+  Topic t;
+  if (it != topics.end()) {
+    t = it->second;
+  } else {
+    size_t slash = key.rfind('/');
+    size_t name = slash == std::string::npos ? 0 : slash + 1;
+    t.metric = campusMetric(key.data() + name, key.size() - name);
+    if (t.metric < 0) {
+      skipped++;
+      return false;
+    }
+    if (topics.size() >= maxTopics) {
+      overLimit++;
+      return false;
+    }
+    if (slash == std::string::npos) {
+      t.series = store.series(key, INGEST_DEFAULT_NODE);
+    } else {
+      t.series = store.series(key.substr(name), key.substr(0, slash));
+    }
+    if (t.series < 0) {
+      skipped++;
+      return false;
+    }
+    topics.emplace(key, t);
+  }
+
+  double value;
+  if (!parseReading(t.metric, payload, payloadLen, value) ||
+      !store.append(t.series, nowMs, value)) {
+    skipped++;
+    return false;
+  }
+  stored++;
+  return true;
+}
+
+uint64_t Ingestor::accepted() const { return stored; }
+
+uint64_t Ingestor::ignored() const { return skipped; }
+
+uint64_t Ingestor::refused() const { return overLimit; }
@@ -0,0 +1,97 @@
+/**
+ * @file Ingestor.hpp
+ * @brief MQTT Message to Time-Series Sample Mapping
+ *
+ * Turns the messages published by the Smart Campus nodes into samples of a
+ * TimeSeriesStore:
+ * - The last topic level is the metric, everything before it the node:
+ *   @c "building-a/room-101/Lx" is metric @c Lx of node
+ *   @c building-a/room-101. Topics without a prefix (what a single node
+ *   publishes, e.g. @c "Lx") belong to node INGEST_DEFAULT_NODE.
+ * - Only the metrics in ::CampusMetric are stored. Numeric payloads are
+ *   stored as-is; the text states of @c Door and @c Motion are mapped to
+ *   numbers (see parseReading()). Other topics and text are ignored.
+ *
+ * Topic to series lookups are cached, so steady-state ingestion costs one
+ * hash lookup and one append per message. Only stored topics are cached,
+ * and at most maxTopics of them, so neither the cache nor the store grows
+ * without bound whatever is published on the broker.
+ */
+
+#ifndef INGESTOR_H
+#define INGESTOR_H
+
+#include "CampusTopics.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/** @brief Node name for topics without a node prefix */
+#define INGEST_DEFAULT_NODE "default"
+
+/** @brief Default limit on distinct topics (and thus new series) */
+#define INGEST_MAX_TOPICS 65536
+
+/**
+ * @class Ingestor
+ * @brief Maps incoming messages to store appends
+ */
+class Ingestor {
+public:
+  /**
+   * @param[in] store Store to append to
+   * @param[in] maxTopics Topics after which new ones are refused
+   */
+  explicit Ingestor(TimeSeriesStore &store,
+                    size_t maxTopics = INGEST_MAX_TOPICS);
+
+  /**
+   * @brief Store one message
+   *
+   * @param[in] topic Topic name (not NUL-terminated)
+   * @param[in] topicLen Length of @p topic
+   * @param[in] payload Payload bytes
+   * @param[in] payloadLen Length of @p payload
+   * @param[in] nowMs Receive time, ms since the epoch
+   *
+   * @return @c true if a sample was appended
+   */
+  bool handle(const char *topic, size_t topicLen, const uint8_t *payload,
+              size_t payloadLen, int64_t nowMs);
+
+  /** @brief Messages stored */
+  uint64_t accepted() const;
+
+  /**
+   * @brief Messages ignored (unknown metrics, text payloads, invalid names,
+   * full disk)
+   */
+  uint64_t ignored() const;
+
+  /** @brief Messages refused because maxTopics was reached */
+  uint64_t refused() const;
+
+private:
+  TimeSeriesStore &store;
+  size_t maxTopics;
+
+  struct Topic {
+    int32_t series; ///< Store handle
+    int metric;     ///< ::CampusMetric
+  };
+
+  /** @brief Topic to series and metric */
+  std::unordered_map<std::string, Topic> topics;
+
+  /** @brief Lookup key, kept so its buffer is reused */
+  std::string key;
+
+  uint64_t stored;
+  uint64_t skipped;
+  uint64_t overLimit;
+};
+
+#endif // INGESTOR_H
@@ -0,0 +1,845 @@
+#include "TimeSeriesStore.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// "TSB1", written last when a block is allocated
+#define BLOCK_MAGIC 0x31425354u
+
+#define SEGMENT_BYTES ((size_t)TSDB_BLOCK_BYTES * TSDB_SEGMENT_BLOCKS)
+
+enum BlockKind : uint8_t { BLOCK_RAW = 1, BLOCK_MINUTE = 2, BLOCK_HOUR = 3 };
+
+/*
+        Header at the start of every block. count is the only
+        field readers rely on while the writer is active: it is
+        stored with release semantics after the data it covers.
+        For raw blocks firstTime/firstValue hold sample 0 and
+        last* the most recent sample; for rollup blocks the time
+        fields hold the first and last record start.
+*/
+struct BlockHeader {
+  uint32_t magic;
+  uint32_t series;
+  uint32_t count;
+  uint16_t timeBytes;
+  uint16_t valueBytes;
+  uint8_t kind;
+  uint8_t reserved[7];
+  int64_t firstTime;
+  int64_t lastTime;
+  int64_t firstValue;
+  int64_t lastValue;
+};
+static_assert(sizeof(BlockHeader) == 56, "block header layout");
+static_assert(sizeof(Rollup) == 24, "rollup record layout");
+
+#define ROLLUPS_PER_BLOCK                                                     \
+  ((TSDB_BLOCK_BYTES - sizeof(BlockHeader)) / sizeof(Rollup))
+
+struct TimeSeriesStore::Metric {
+  std::string name;
+  std::string dir;
+  std::vector<uint8_t *> segments;
+  uint32_t usedBlocks = 0;
+  int seriesFd = -1;
+  // Series id within the metric to handle in seriesList
+  std::vector<int32_t> series;
+  std::unordered_map<std::string, int32_t> byNode;
+};
+
+// Decode position in a series' raw blocks: next sample to read
+struct RawPosition {
+  size_t block;
+  uint32_t sample;
+  uint16_t timeBytes;
+  uint16_t valueBytes;
+  int64_t time;
+  int64_t value;
+};
+
+struct TimeSeriesStore::Series {
+  Metric *metric;
+  uint32_t id;
+  std::string node;
+  // Block ids in time order
+  std::vector<uint32_t> raw;
+  std::vector<uint32_t> minutes;
+  std::vector<uint32_t> hours;
+  // Rollup progress: samples before rolledMinute are in minute records
+  // and rollPosition points at the first one that is not; minute records
+  // before minuteIndex are in hour records, which cover everything before
+  // rolledHour
+  int64_t rolledMinute;
+  int64_t rolledHour;
+  RawPosition rollPosition;
+  size_t minuteIndex;
+};
+
+static inline int64_t floorTo(int64_t t, int64_t step) {
+  int64_t q = t / step;
+  if (t < 0 && q * step != t) {
+    q--;
+  }
+  return q * step;
+}
+
+static inline uint64_t zigzag(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static inline int64_t unzigzag(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static inline size_t putVarint(uint8_t *out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+static inline uint64_t getVarint(const uint8_t *&p) {
+  uint64_t v = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t b = *p++;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return v;
+    }
+  }
+}
+
+// Value column runs backwards from the end of the block
+static inline uint64_t getVarintBackward(const uint8_t *&p) {
+  uint64_t v = 0;
+  for (int shift = 0;; shift += 7) {
+    uint8_t b = *p--;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return v;
+    }
+  }
+}
+
+static inline uint32_t loadCount(const BlockHeader *h) {
+  return __atomic_load_n(&h->count, __ATOMIC_ACQUIRE);
+}
+
+static inline void publishCount(BlockHeader *h, uint32_t count) {
+  __atomic_store_n(&h->count, count, __ATOMIC_RELEASE);
+}
+
+static inline const Rollup *records(const uint8_t *blk) {
+  return reinterpret_cast<const Rollup *>(blk + sizeof(BlockHeader));
+}
+
+static bool validName(const std::string &name) {
+  if (name.empty() || name.size() > 64 || name[0] == '.') {
+    return false;
+  }
+  for (char c : name) {
+    if (!isalnum((unsigned char)c) && c != '.' && c != '_' && c != '-') {
+      return false;
+    }
+  }
+  return true;
+}
+
+SampleCursor::SampleCursor()
+    : nextBlock(0), left(0), tp(nullptr), vp(nullptr), time(0), value(0),
+      first(false), from(0), to(0) {}
+
+bool SampleCursor::next(int64_t &timeMs, float &out) {
+  for (;;) {
+    if (left == 0) {
+      if (nextBlock >= blocks.size()) {
+        return false;
+      }
+      const uint8_t *blk = blocks[nextBlock++];
+      const BlockHeader *h = reinterpret_cast<const BlockHeader *>(blk);
+      left = loadCount(h);
+      tp = blk + sizeof(BlockHeader);
+      vp = blk + TSDB_BLOCK_BYTES - 1;
+      time = h->firstTime;
+      value = h->firstValue;
+      first = true;
+      continue;
+    }
+
+    if (!first) {
+      time += (int64_t)getVarint(tp);
+      value += unzigzag(getVarintBackward(vp));
+    }
+    first = false;
+    left--;
+
+    if (time < from) {
+      continue;
+    }
+    if (time >= to) {
+      blocks.clear();
+      left = 0;
+      return false;
+    }
+    timeMs = time;
+    out = (float)value / TSDB_VALUE_SCALE;
+    return true;
+  }
+}
+
+TimeSeriesStore::TimeSeriesStore()
+    : readOnly(false), lastRollupEdge(LLONG_MIN), samplesIn(0), bytesIn(0) {}
+
+TimeSeriesStore::~TimeSeriesStore() { close(); }
+
+bool TimeSeriesStore::open(const std::string &dir, bool ro) {
+  close();
+  root = dir;
+  readOnly = ro;
+
+  if (!readOnly && mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "tsdb: cannot create %s: %s\n", dir.c_str(),
+            strerror(errno));
+    return false;
+  }
+  DIR *d = opendir(dir.c_str());
+  if (!d) {
+    fprintf(stderr, "tsdb: cannot open %s: %s\n", dir.c_str(),
+            strerror(errno));
+    return false;
+  }
+  std::vector<std::string> names;
+  while (dirent *e = readdir(d)) {
+    if (validName(e->d_name)) {
+      names.push_back(e->d_name);
+    }
+  }
+  closedir(d);
+
+  std::sort(names.begin(), names.end());
+  for (const std::string &name : names) {
+    if (!metric(name, false)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void TimeSeriesStore::close() {
+  sync();
+  for (auto &m : metricList) {
+    for (uint8_t *seg : m->segments) {
+      munmap(seg, SEGMENT_BYTES);
+    }
+    if (m->seriesFd >= 0) {
+      ::close(m->seriesFd);
+    }
+  }
+  metricList.clear();
+  seriesList.clear();
+  metricIndex.clear();
+  lastRollupEdge = LLONG_MIN;
+  samplesIn = bytesIn = 0;
+}
+
+uint8_t *TimeSeriesStore::block(const Metric &m, uint32_t id) {
+  return m.segments[id / TSDB_SEGMENT_BLOCKS] +
+         (size_t)(id % TSDB_SEGMENT_BLOCKS) * TSDB_BLOCK_BYTES;
+}
+
+static std::string segmentPath(const std::string &dir, size_t n) {
+  char name[32];
+  snprintf(name, sizeof(name), "/%06zu.seg", n);
+  return dir + name;
+}
+
+bool TimeSeriesStore::mapSegment(Metric &m, size_t n) {
+  std::string file = segmentPath(m.dir, n);
+
+  int fd = ::open(file.c_str(), readOnly ? O_RDONLY : O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "tsdb: cannot open %s: %s\n", file.c_str(),
+            strerror(errno));
+    return false;
+  }
+  // New segments are sparse; blocks take disk space as they are written
+  if (!readOnly && ftruncate(fd, SEGMENT_BYTES) != 0) {
+    fprintf(stderr, "tsdb: cannot size %s: %s\n", file.c_str(),
+            strerror(errno));
+    ::close(fd);
+    return false;
+  }
+  void *p = mmap(nullptr, SEGMENT_BYTES,
+                 readOnly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED,
+                 fd, 0);
+  ::close(fd);
+  if (p == MAP_FAILED) {
+    fprintf(stderr, "tsdb: cannot map %s: %s\n", file.c_str(),
+            strerror(errno));
+    return false;
+  }
+  m.segments.push_back(static_cast<uint8_t *>(p));
+  return true;
+}
+
+TimeSeriesStore::Metric *TimeSeriesStore::metric(const std::string &name,
+                                                 bool create) {
+  auto it = metricIndex.find(name);
+  if (it != metricIndex.end()) {
+    return metricList[it->second].get();
+  }
+  if (!validName(name) || metricList.size() >= TSDB_MAX_METRICS) {
+    return nullptr;
+  }
+
+  std::unique_ptr<Metric> m(new Metric);
+  m->name = name;
+  m->dir = root + "/" + name;
+  if (create && mkdir(m->dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "tsdb: cannot create %s: %s\n", m->dir.c_str(),
+            strerror(errno));
+    return nullptr;
+  }
+
+  // Series names first: blocks refer to series by line number
+  std::string seriesPath = m->dir + "/series";
+  int fd = ::open(seriesPath.c_str(),
+                  readOnly ? O_RDONLY : O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd < 0) {
+    fprintf(stderr, "tsdb: cannot open %s: %s\n", seriesPath.c_str(),
+            strerror(errno));
+    return nullptr;
+  }
+  std::string text;
+  char buf[65536];
+  ssize_t n;
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    text.append(buf, (size_t)n);
+  }
+  if (readOnly) {
+    ::close(fd);
+  } else {
+    m->seriesFd = fd;
+  }
+
+  Metric *raw = m.get();
+  metricIndex[name] = metricList.size();
+  metricList.push_back(std::move(m));
+
+  size_t start = 0, end;
+  while ((end = text.find('\n', start)) != std::string::npos) {
+    Series s{};
+    s.metric = raw;
+    s.id = (uint32_t)raw->series.size();
+    s.node = text.substr(start, end - start);
+    s.rolledMinute = s.rolledHour = LLONG_MIN;
+    raw->byNode[s.node] = (int32_t)seriesList.size();
+    raw->series.push_back((int32_t)seriesList.size());
+    seriesList.push_back(std::move(s));
+    start = end + 1;
+  }
+
+  struct stat st;
+  while (stat(segmentPath(raw->dir, raw->segments.size()).c_str(), &st) ==
+         0) {
+    if (!mapSegment(*raw, raw->segments.size())) {
+      return nullptr;
+    }
+  }
+  scan(*raw);
+  return raw;
+}
+
+/*
+        Decode the sample at pos if it is earlier than limit and
+        advance past it. Moves on to the next block once a full
+        one is consumed; stays put at the end of the last block,
+        where the writer is still appending.
+*/
+static bool stepRaw(const std::vector<uint8_t *> &segments,
+                    const std::vector<uint32_t> &raw, RawPosition &pos,
+                    int64_t limit, int64_t &time, int64_t &value) {
+  for (;;) {
+    if (pos.block >= raw.size()) {
+      return false;
+    }
+    uint32_t id = raw[pos.block];
+    const uint8_t *blk = segments[id / TSDB_SEGMENT_BLOCKS] +
+                         (size_t)(id % TSDB_SEGMENT_BLOCKS) * TSDB_BLOCK_BYTES;
+    const BlockHeader *h = reinterpret_cast<const BlockHeader *>(blk);
+
+    if (pos.sample == h->count) {
+      if (pos.block + 1 == raw.size()) {
+        return false;
+      }
+      pos = RawPosition{pos.block + 1, 0, 0, 0, 0, 0};
+      continue;
+    }
+
+    const uint8_t *tp = blk + sizeof(BlockHeader) + pos.timeBytes;
+    const uint8_t *vp = blk + TSDB_BLOCK_BYTES - 1 - pos.valueBytes;
+    if (pos.sample == 0) {
+      time = h->firstTime;
+      value = h->firstValue;
+    } else {
+      time = pos.time + (int64_t)getVarint(tp);
+      value = pos.value + unzigzag(getVarintBackward(vp));
+    }
+    if (time >= limit) {
+      return false;
+    }
+    pos.sample++;
+    pos.timeBytes = (uint16_t)(tp - blk - sizeof(BlockHeader));
+    pos.valueBytes = (uint16_t)(blk + TSDB_BLOCK_BYTES - 1 - vp);
+    pos.time = time;
+    pos.value = value;
+    return true;
+  }
+}
+
+/*
+        Blocks are allocated in order, so the first block without
+        a magic number ends the used area. Afterwards rebuild the
+        writer's state: the tail of every raw block list is
+        re-decoded (a crash may have left header fields ahead of
+        count) and rollup progress is derived from the last
+        rollup record of each level.
+*/
+void TimeSeriesStore::scan(Metric &m) {
+  uint32_t total = (uint32_t)(m.segments.size() * TSDB_SEGMENT_BLOCKS);
+  uint32_t id = 0;
+  for (; id < total; id++) {
+    const BlockHeader *h = reinterpret_cast<const BlockHeader *>(block(m, id));
+    if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != BLOCK_MAGIC) {
+      break;
+    }
+    if (h->series >= m.series.size()) {
+      continue; // Name not flushed before a crash; block is orphaned
+    }
+    Series &s = seriesList[m.series[h->series]];
+    if (h->kind == BLOCK_RAW) {
+      s.raw.push_back(id);
+    } else if (h->kind == BLOCK_MINUTE) {
+      s.minutes.push_back(id);
+    } else if (h->kind == BLOCK_HOUR) {
+      s.hours.push_back(id);
+    }
+  }
+  m.usedBlocks = id;
+  if (readOnly) {
+    return;
+  }
+
+  for (int32_t handle : m.series) {
+    Series &s = seriesList[handle];
+    if (s.raw.empty()) {
+      continue;
+    }
+
+    BlockHeader *tail = reinterpret_cast<BlockHeader *>(block(m, s.raw.back()));
+    const uint8_t *tp = reinterpret_cast<uint8_t *>(tail) + sizeof(BlockHeader);
+    const uint8_t *vp = reinterpret_cast<uint8_t *>(tail) + TSDB_BLOCK_BYTES - 1;
+    const uint8_t *t0 = tp, *v0 = vp;
+    int64_t t = tail->firstTime, v = tail->firstValue;
+    for (uint32_t i = 1; i < tail->count; i++) {
+      t += (int64_t)getVarint(tp);
+      v += unzigzag(getVarintBackward(vp));
+    }
+    tail->timeBytes = (uint16_t)(tp - t0);
+    tail->valueBytes = (uint16_t)(v0 - vp);
+    tail->lastTime = t;
+    tail->lastValue = v;
+
+    const BlockHeader *first =
+        reinterpret_cast<const BlockHeader *>(block(m, s.raw.front()));
+    s.rolledMinute = floorTo(first->firstTime, TSDB_MINUTE_MS);
+    if (!s.minutes.empty()) {
+      const BlockHeader *h =
+          reinterpret_cast<const BlockHeader *>(block(m, s.minutes.back()));
+      s.rolledMinute = h->lastTime + TSDB_MINUTE_MS;
+    }
+    s.rollPosition = RawPosition{};
+    while (s.rollPosition.block + 1 < s.raw.size() &&
+           reinterpret_cast<const BlockHeader *>(
+               block(m, s.raw[s.rollPosition.block]))
+                   ->lastTime < s.rolledMinute) {
+      s.rollPosition.block++;
+    }
+    while (stepRaw(m.segments, s.raw, s.rollPosition, s.rolledMinute, t, v)) {
+    }
+
+    s.rolledHour = floorTo(first->firstTime, TSDB_HOUR_MS);
+    if (!s.hours.empty()) {
+      const BlockHeader *h =
+          reinterpret_cast<const BlockHeader *>(block(m, s.hours.back()));
+      s.rolledHour = h->lastTime + TSDB_HOUR_MS;
+    }
+    s.minuteIndex = 0;
+    for (uint32_t b : s.minutes) {
+      const BlockHeader *h = reinterpret_cast<const BlockHeader *>(block(m, b));
+      const Rollup *r = records(block(m, b));
+      uint32_t i = 0;
+      while (i < h->count && r[i].start < s.rolledHour) {
+        i++;
+      }
+      s.minuteIndex += i;
+      if (i < h->count) {
+        break;
+      }
+    }
+  }
+}
+
+uint8_t *TimeSeriesStore::allocate(Metric &m, uint32_t &id) {
+  if (m.usedBlocks == m.segments.size() * TSDB_SEGMENT_BLOCKS &&
+      !mapSegment(m, m.segments.size())) {
+    return nullptr;
+  }
+  id = m.usedBlocks++;
+  return block(m, id);
+}
+
+int32_t TimeSeriesStore::series(const std::string &metricName,
+                                const std::string &node) {
+  if (readOnly && !metricIndex.count(metricName)) {
+    return -1;
+  }
+  Metric *m = metric(metricName, !readOnly);
+  if (!m) {
+    return -1;
+  }
+  auto it = m->byNode.find(node);
+  if (it != m->byNode.end()) {
+    return it->second;
+  }
+  if (readOnly || node.find('\n') != std::string::npos) {
+    return -1;
+  }
+
+  // The name must be on disk before any block refers to it
+  std::string line = node + "\n";
+  if (write(m->seriesFd, line.data(), line.size()) != (ssize_t)line.size()) {
+    fprintf(stderr, "tsdb: cannot add series %s/%s: %s\n", metricName.c_str(),
+            node.c_str(), strerror(errno));
+    return -1;
+  }
+
+  Series s{};
+  s.metric = m;
+  s.id = (uint32_t)m->series.size();
+  s.node = node;
+  s.rolledMinute = s.rolledHour = LLONG_MIN;
+  int32_t handle = (int32_t)seriesList.size();
+  m->byNode[node] = handle;
+  m->series.push_back(handle);
+  seriesList.push_back(std::move(s));
+  return handle;
+}
+
+bool TimeSeriesStore::append(int32_t handle, int64_t timeMs, double v) {
+  if (readOnly || handle < 0 || (size_t)handle >= seriesList.size()) {
+    return false;
+  }
+  Series &s = seriesList[handle];
+  Metric &m = *s.metric;
+  int64_t value = llround(v * TSDB_VALUE_SCALE);
+
+  if (!s.raw.empty()) {
+    uint8_t *blk = block(m, s.raw.back());
+    BlockHeader *h = reinterpret_cast<BlockHeader *>(blk);
+    if (timeMs < h->lastTime) {
+      timeMs = h->lastTime;
+    }
+    uint8_t tb[10], vb[10];
+    size_t nt = putVarint(tb, (uint64_t)(timeMs - h->lastTime));
+    size_t nv = putVarint(vb, zigzag(value - h->lastValue));
+    if (sizeof(BlockHeader) + h->timeBytes + nt + h->valueBytes + nv <=
+        TSDB_BLOCK_BYTES) {
+      memcpy(blk + sizeof(BlockHeader) + h->timeBytes, tb, nt);
+      uint8_t *vp = blk + TSDB_BLOCK_BYTES - 1 - h->valueBytes;
+      for (size_t i = 0; i < nv; i++) {
+        *vp-- = vb[i];
+      }
+      h->timeBytes = (uint16_t)(h->timeBytes + nt);
+      h->valueBytes = (uint16_t)(h->valueBytes + nv);
+      h->lastTime = timeMs;
+      h->lastValue = value;
+      publishCount(h, h->count + 1);
+      samplesIn++;
+      bytesIn += nt + nv;
+      return true;
+    }
+  }
+
+  uint32_t id;
+  uint8_t *blk = allocate(m, id);
+  if (!blk) {
+    return false;
+  }
+  BlockHeader *h = reinterpret_cast<BlockHeader *>(blk);
+  memset(h, 0, sizeof(*h));
+  h->series = s.id;
+  h->kind = BLOCK_RAW;
+  h->firstTime = h->lastTime = timeMs;
+  h->firstValue = h->lastValue = value;
+  h->count = 1;
+  __atomic_store_n(&h->magic, BLOCK_MAGIC, __ATOMIC_RELEASE);
+  s.raw.push_back(id);
+
+  if (s.rolledMinute == LLONG_MIN) {
+    s.rolledMinute = floorTo(timeMs, TSDB_MINUTE_MS);
+    s.rolledHour = floorTo(timeMs, TSDB_HOUR_MS);
+  }
+  samplesIn++;
+  bytesIn += 16; // First time and value, kept in the header
+  return true;
+}
+
+bool TimeSeriesStore::appendRollup(Series &s, RollupLevel level,
+                                   const Rollup &r) {
+  Metric &m = *s.metric;
+  std::vector<uint32_t> &list = level == ROLLUP_MINUTE ? s.minutes : s.hours;
+
+  if (!list.empty()) {
+    uint8_t *blk = block(m, list.back());
+    BlockHeader *h = reinterpret_cast<BlockHeader *>(blk);
+    if (h->count < ROLLUPS_PER_BLOCK) {
+      reinterpret_cast<Rollup *>(blk + sizeof(BlockHeader))[h->count] = r;
+      h->lastTime = r.start;
+      publishCount(h, h->count + 1);
+      return true;
+    }
+  }
+
+  uint32_t id;
+  uint8_t *blk = allocate(m, id);
+  if (!blk) {
+    return false;
+  }
+  BlockHeader *h = reinterpret_cast<BlockHeader *>(blk);
+  memset(h, 0, sizeof(*h));
+  h->series = s.id;
+  h->kind = level == ROLLUP_MINUTE ? BLOCK_MINUTE : BLOCK_HOUR;
+  h->firstTime = h->lastTime = r.start;
+  reinterpret_cast<Rollup *>(blk + sizeof(BlockHeader))[0] = r;
+  h->count = 1;
+  __atomic_store_n(&h->magic, BLOCK_MAGIC, __ATOMIC_RELEASE);
+  list.push_back(id);
+  return true;
+}
+
+// Running aggregate of one bucket
+struct Bucket {
+  int64_t start = LLONG_MIN;
+  double sum = 0;
+  float min = 0, max = 0;
+  uint32_t count = 0;
+
+  void add(int64_t bucketStart, float lo, float hi, double s, uint32_t n) {
+    if (count == 0) {
+      start = bucketStart;
+      min = lo;
+      max = hi;
+    }
+    min = std::min(min, lo);
+    max = std::max(max, hi);
+    sum += s;
+    count += n;
+  }
+
+  Rollup take() {
+    Rollup r{start, min, max, (float)(sum / count), count};
+    sum = 0;
+    count = 0;
+    return r;
+  }
+};
+
+size_t TimeSeriesStore::rollMinutes(Series &s, int64_t edge) {
+  if (s.raw.empty() || s.rolledMinute >= edge) {
+    return 0;
+  }
+  Bucket bucket;
+  size_t written = 0;
+  int64_t t, v;
+
+  // Only samples added since the previous pass are decoded
+  while (stepRaw(s.metric->segments, s.raw, s.rollPosition, edge, t, v)) {
+    int64_t start = floorTo(t, TSDB_MINUTE_MS);
+    if (bucket.count && bucket.start != start) {
+      written += appendRollup(s, ROLLUP_MINUTE, bucket.take());
+    }
+    float value = (float)v / TSDB_VALUE_SCALE;
+    bucket.add(start, value, value, value, 1);
+  }
+  if (bucket.count) {
+    written += appendRollup(s, ROLLUP_MINUTE, bucket.take());
+  }
+  s.rolledMinute = edge;
+  return written;
+}
+
+size_t TimeSeriesStore::rollHours(Series &s, int64_t edge) {
+  if (s.minutes.empty() || s.rolledHour >= edge) {
+    return 0;
+  }
+  Metric &m = *s.metric;
+  Bucket bucket;
+  size_t written = 0;
+
+  for (;;) {
+    size_t b = s.minuteIndex / ROLLUPS_PER_BLOCK;
+    size_t i = s.minuteIndex % ROLLUPS_PER_BLOCK;
+    if (b >= s.minutes.size()) {
+      break;
+    }
+    const uint8_t *blk = block(m, s.minutes[b]);
+    if (i >= reinterpret_cast<const BlockHeader *>(blk)->count) {
+      break;
+    }
+    const Rollup &r = records(blk)[i];
+    if (r.start >= edge) {
+      break;
+    }
+    int64_t start = floorTo(r.start, TSDB_HOUR_MS);
+    if (bucket.count && bucket.start != start) {
+      written += appendRollup(s, ROLLUP_HOUR, bucket.take());
+    }
+    bucket.add(start, r.min, r.max, (double)r.avg * r.count, r.count);
+    s.minuteIndex++;
+  }
+  if (bucket.count) {
+    written += appendRollup(s, ROLLUP_HOUR, bucket.take());
+  }
+  s.rolledHour = edge;
+  return written;
+}
+
+size_t TimeSeriesStore::rollup(int64_t nowMs) {
+  int64_t minuteEdge = floorTo(nowMs - TSDB_ROLLUP_GRACE_MS, TSDB_MINUTE_MS);
+  if (readOnly || minuteEdge == lastRollupEdge) {
+    return 0;
+  }
+  int64_t hourEdge = floorTo(nowMs - TSDB_ROLLUP_GRACE_MS, TSDB_HOUR_MS);
+  lastRollupEdge = minuteEdge;
+
+  size_t written = 0;
+  for (Series &s : seriesList) {
+    written += rollMinutes(s, minuteEdge);
+    written += rollHours(s, hourEdge);
+  }
+  return written;
+}
+
+void TimeSeriesStore::sync() {
+  if (readOnly) {
+    return;
+  }
+  for (auto &m : metricList) {
+    for (uint8_t *seg : m->segments) {
+      msync(seg, SEGMENT_BYTES, MS_ASYNC);
+    }
+  }
+}
+
+SampleCursor TimeSeriesStore::samples(int32_t handle, int64_t from,
+                                      int64_t to) const {
+  SampleCursor c;
+  if (handle < 0 || (size_t)handle >= seriesList.size()) {
+    return c;
+  }
+  const Series &s = seriesList[handle];
+  const Metric &m = *s.metric;
+
+  // Start at the last block beginning at or before from
+  auto first = std::upper_bound(
+      s.raw.begin(), s.raw.end(), from, [&](int64_t t, uint32_t id) {
+        return t < reinterpret_cast<const BlockHeader *>(block(m, id))
+                       ->firstTime;
+      });
+  if (first != s.raw.begin()) {
+    --first;
+  }
+  for (auto it = first; it != s.raw.end(); ++it) {
+    c.blocks.push_back(block(m, *it));
+  }
+  c.from = from;
+  c.to = to;
+  return c;
+}
+
+void TimeSeriesStore::rollups(int32_t handle, RollupLevel level, int64_t from,
+                              int64_t to,
+                              const RollupHandler &onRecords) const {
+  if (handle < 0 || (size_t)handle >= seriesList.size()) {
+    return;
+  }
+  const Series &s = seriesList[handle];
+  const std::vector<uint32_t> &list =
+      level == ROLLUP_MINUTE ? s.minutes : s.hours;
+
+  for (uint32_t id : list) {
+    const uint8_t *blk = block(*s.metric, id);
+    const BlockHeader *h = reinterpret_cast<const BlockHeader *>(blk);
+    uint32_t count = loadCount(h);
+    if (count == 0 || h->firstTime >= to) {
+      break;
+    }
+    const Rollup *begin = records(blk), *end = begin + count;
+    const Rollup *lo = std::lower_bound(
+        begin, end, from,
+        [](const Rollup &r, int64_t t) { return r.start < t; });
+    const Rollup *hi = std::lower_bound(
+        lo, end, to, [](const Rollup &r, int64_t t) { return r.start < t; });
+    if (hi > lo) {
+      onRecords(lo, (size_t)(hi - lo));
+    }
+  }
+}
+
+std::vector<std::string> TimeSeriesStore::metrics() const {
+  std::vector<std::string> names;
+  for (const auto &m : metricList) {
+    names.push_back(m->name);
+  }
+  return names;
+}
+
+std::vector<std::string>
+TimeSeriesStore::nodes(const std::string &metricName) const {
+  std::vector<std::string> names;
+  auto it = metricIndex.find(metricName);
+  if (it != metricIndex.end()) {
+    for (int32_t handle : metricList[it->second]->series) {
+      names.push_back(seriesList[handle].node);
+    }
+  }
+  return names;
+}
+
+size_t TimeSeriesStore::seriesCount() const { return seriesList.size(); }
+
+uint64_t TimeSeriesStore::samplesAppended() const { return samplesIn; }
+
+uint64_t TimeSeriesStore::bytesAppended() const { return bytesIn; }
+
+uint64_t TimeSeriesStore::blocksAllocated() const {
+  uint64_t n = 0;
+  for (const auto &m : metricList) {
+    n += m->usedBlocks;
+  }
+  return n;
+}
@@ -0,0 +1,311 @@
+/**
+ * @file TimeSeriesStore.hpp
+ * @brief Memory-Mapped Columnar Time-Series Store
+ *
+ * Stores the sensor history of the whole campus on local disk for the ingest
+ * daemon (campus_ingest) and answers range queries straight out of the
+ * mapped files (campus_query, dashboards).
+ *
+ * Layout on disk:
+ * @code
+ * <dir>/<metric>/series        node names, one per line, line n = series n
+ * <dir>/<metric>/000000.seg    16 MiB segments of 4 KiB blocks, mmap'ed
+ * <dir>/<metric>/000001.seg    ...
+ * @endcode
+ *
+ * Every block belongs to one series and holds either raw samples or rollup
+ * records:
+ * - Raw blocks are columnar: the first sample lives in the block header,
+ *   then timestamp deltas (varint) grow forward from the header while value
+ *   deltas (zigzag varint) grow backward from the end of the block.
+ * - Rollup blocks hold fixed-size Rollup records (1 min and 1 h min/max/avg)
+ *   that queries hand out as pointers into the mapping, without copying.
+ *
+ * Storage cost, as measured by ingest_bench for the firmware's topics:
+ * - raw samples encode to about 4 bytes each;
+ * - rollups add a 24-byte record per series for every minute and hour with
+ *   samples, up to about 34 KiB per series per day, which is more than the
+ *   raw data of a sensor reporting every minute (about 11 bytes per sample
+ *   in the bench);
+ * - every series pins three 4 KiB blocks (raw, 1 min, 1 h) as soon as it
+ *   has data, so a store costs at least 12 KiB per series. 30000 series
+ *   over 2 hours allocate 62 bytes per sample; 1200 series over 24 hours
+ *   allocate 18.
+ *
+ * Blocks are allocated in order and published with release stores, so a
+ * reader process mapping the same files sees consistent data while the
+ * writer keeps appending.
+ *
+ * @note One writer per directory; not thread-safe
+ */
+
+#ifndef TIME_SERIES_STORE_H
+#define TIME_SERIES_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @defgroup TimeSeriesStore_Config Time-Series Store Configuration Constants
+ * @{
+ */
+
+/** @brief Size of one block; a block belongs to a single series */
+#define TSDB_BLOCK_BYTES 4096
+
+/** @brief Blocks per segment file (16 MiB, created sparse) */
+#define TSDB_SEGMENT_BLOCKS 4096
+
+/**
+ * @brief Fixed-point scale of stored values
+ *
+ * The firmware publishes two decimals, so values are kept as integers in
+ * hundredths and their deltas stay small.
+ */
+#define TSDB_VALUE_SCALE 100
+
+/** @brief Length of the fine rollup bucket */
+#define TSDB_MINUTE_MS 60000LL
+
+/** @brief Length of the coarse rollup bucket */
+#define TSDB_HOUR_MS 3600000LL
+
+/** @brief Time after a bucket ends before it is rolled up */
+#define TSDB_ROLLUP_GRACE_MS 5000
+
+/** @brief Maximum number of metrics (directories) in one store */
+#define TSDB_MAX_METRICS 64
+
+/** @} */
+
+/**
+ * @brief Aggregate of one series over one bucket, stored as-is on disk
+ */
+struct Rollup {
+  /** @brief Bucket start, ms since the epoch */
+  int64_t start;
+
+  /** @brief Smallest, largest and mean value in the bucket */
+  float min;
+  float max;
+  float avg;
+
+  /** @brief Number of raw samples in the bucket */
+  uint32_t count;
+};
+
+/**
+ * @brief Rollup resolution
+ */
+enum RollupLevel {
+  ROLLUP_MINUTE, ///< 1 min buckets
+  ROLLUP_HOUR    ///< 1 h buckets
+};
+
+/**
+ * @class SampleCursor
+ * @brief Iterator over the raw samples of one series in a time range
+ *
+ * Decodes the varint columns directly from the mapped blocks; nothing is
+ * copied or allocated per sample.
+ */
+class SampleCursor {
+public:
+  SampleCursor();
+
+  /**
+   * @brief Fetch the next sample
+   *
+   * @param[out] timeMs Sample time, ms since the epoch
+   * @param[out] value Sample value
+   *
+   * @return @c false once the range is exhausted
+   */
+  bool next(int64_t &timeMs, float &value);
+
+private:
+  friend class TimeSeriesStore;
+
+  /** @brief Addresses of the series' raw blocks from the first relevant one */
+  std::vector<const uint8_t *> blocks;
+
+  /** @brief Index of the next block in @ref blocks */
+  size_t nextBlock;
+
+  /** @brief Samples left in the current block */
+  uint32_t left;
+
+  /** @brief Read positions in the time and value columns */
+  const uint8_t *tp;
+  const uint8_t *vp;
+
+  /** @brief Running time and fixed-point value */
+  int64_t time;
+  int64_t value;
+
+  /** @brief Next sample is the block's first (stored in the header) */
+  bool first;
+
+  /** @brief Half-open time range [from, to) */
+  int64_t from;
+  int64_t to;
+};
+
+/**
+ * @class TimeSeriesStore
+ * @brief Append-only store of (time, value) series grouped by metric
+ */
+class TimeSeriesStore {
+public:
+  /**
+   * @brief Handler receiving a run of rollup records
+   *
+   * @param records Records inside the mapped file, valid until close()
+   * @param count Number of records at @p records
+   */
+  using RollupHandler = std::function<void(const Rollup *records, size_t count)>;
+
+  TimeSeriesStore();
+  ~TimeSeriesStore();
+
+  TimeSeriesStore(const TimeSeriesStore &) = delete;
+  TimeSeriesStore &operator=(const TimeSeriesStore &) = delete;
+
+  /**
+   * @brief Open (and create if needed) a store directory
+   *
+   * Maps every existing segment and rebuilds the in-memory series index by
+   * scanning block headers.
+   *
+   * @param[in] dir Store directory
+   * @param[in] readOnly Map read-only, for query processes
+   *
+   * @return @c true on success; errors are printed to stderr
+   */
+  bool open(const std::string &dir, bool readOnly = false);
+
+  /** @brief Unmap everything */
+  void close();
+
+  /**
+   * @brief Look up a series, creating it unless the store is read-only
+   *
+   * @param[in] metric Metric name; letters, digits, '.', '_' and '-' only
+   * @param[in] node Node name; any text without newlines
+   *
+   * @return Series handle for append() and queries, or -1
+   */
+  int32_t series(const std::string &metric, const std::string &node);
+
+  /**
+   * @brief Append one sample
+   *
+   * Times must not go backwards within a series; earlier times are clamped
+   * to the last one.
+   *
+   * @param[in] handle Handle from series()
+   * @param[in] timeMs Sample time, ms since the epoch
+   * @param[in] value Sample value, stored with 1/TSDB_VALUE_SCALE precision
+   *
+   * @return @c false if the store is read-only or out of disk space
+   */
+  bool append(int32_t handle, int64_t timeMs, double value);
+
+  /**
+   * @brief Roll up every bucket that closed before @p nowMs
+   *
+   * Cheap when no bucket boundary has passed since the previous call, so it
+   * can be called from the ingest loop as often as convenient.
+   *
+   * @return Number of rollup records written
+   */
+  size_t rollup(int64_t nowMs);
+
+  /** @brief Schedule write-back of dirty pages (MS_ASYNC) */
+  void sync();
+
+  /**
+   * @brief Raw samples of a series in [from, to)
+   */
+  SampleCursor samples(int32_t handle, int64_t from, int64_t to) const;
+
+  /**
+   * @brief Rollup records of a series with start in [from, to)
+   *
+   * @p onRecords is called once per contiguous run of records, with a
+   * pointer into the mapped block.
+   */
+  void rollups(int32_t handle, RollupLevel level, int64_t from, int64_t to,
+               const RollupHandler &onRecords) const;
+
+  /** @brief Names of all metrics in the store */
+  std::vector<std::string> metrics() const;
+
+  /** @brief Node names of one metric, in series order */
+  std::vector<std::string> nodes(const std::string &metric) const;
+
+  /** @brief Number of series */
+  size_t seriesCount() const;
+
+  /** @brief Raw samples appended since open() */
+  uint64_t samplesAppended() const;
+
+  /** @brief Encoded bytes (headers excluded) appended since open() */
+  uint64_t bytesAppended() const;
+
+  /** @brief Blocks allocated, of all kinds, in all metrics */
+  uint64_t blocksAllocated() const;
+
+private:
+  struct Metric;
+  struct Series;
+
+  /** @brief Store directory */
+  std::string root;
+
+  /** @brief Opened with open(dir, true) */
+  bool readOnly;
+
+  std::vector<std::unique_ptr<Metric>> metricList;
+  std::vector<Series> seriesList;
+
+  /** @brief Metric name to index in @ref metricList */
+  std::unordered_map<std::string, size_t> metricIndex;
+
+  /** @brief Minute bucket edge handled by the last rollup() */
+  int64_t lastRollupEdge;
+
+  uint64_t samplesIn;
+  uint64_t bytesIn;
+
+  /** @brief Find or create a metric and map its segments */
+  Metric *metric(const std::string &name, bool create);
+
+  /** @brief Map segment @p n of @p m, creating the file if needed */
+  bool mapSegment(Metric &m, size_t n);
+
+  /** @brief Allocate the next free block of @p m */
+  uint8_t *allocate(Metric &m, uint32_t &id);
+
+  /** @brief Address of block @p id of @p m */
+  static uint8_t *block(const Metric &m, uint32_t id);
+
+  /** @brief Rebuild series index and tail state from the block headers */
+  void scan(Metric &m);
+
+  /** @brief Append a rollup record to one of a series' rollup lists */
+  bool appendRollup(Series &s, RollupLevel level, const Rollup &r);
+
+  /** @brief Roll a series' raw samples before @p edge into 1 min records */
+  size_t rollMinutes(Series &s, int64_t edge);
+
+  /** @brief Roll a series' 1 min records before @p edge into 1 h records */
+  size_t rollHours(Series &s, int64_t edge);
+};
+
+#endif // TIME_SERIES_STORE_H
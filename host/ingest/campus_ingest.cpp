@@ -0,0 +1,161 @@
+/*
+        Smart Campus ingest daemon
+
+        Subscribes to the sensor readings on the broker and appends
+        them to a TimeSeriesStore. Rollups run in the same loop
+        between message batches, so ingestion needs a single core
+        and no locks. Reconnects forever, so it can start before
+        the broker.
+
+        Without --topic it subscribes to sensorTopicFilters(), which
+        covers node prefixes up to four levels deep. New topics
+        beyond --max-topics are refused (and counted) rather than
+        creating series.
+
+        Usage:
+          campus_ingest [--broker HOST:PORT] [--data DIR]
+                        [--topic FILTER]... [--max-topics N]
+                        [--stats SECONDS]
+*/
+
+#include "CampusTopics.hpp"
+#include "Ingestor.hpp"
+#include "MqttClient.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// How often pending rollups are checked and dirty pages scheduled
+#define ROLLUP_PERIOD_MS 1000
+#define SYNC_PERIOD_MS 10000
+#define RECONNECT_DELAY_S 2
+
+struct Options {
+  std::string brokerHost = "127.0.0.1";
+  uint16_t brokerPort = 1883;
+  std::string data = "tsdb";
+  std::vector<std::string> topics;
+  long maxTopics = INGEST_MAX_TOPICS;
+  int statsSeconds = 60;
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int) { stopping = 1; }
+
+static bool parseArgs(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--broker") && hasValue) {
+      if (!splitHostPort(argv[++i], opt.brokerHost, opt.brokerPort)) {
+        return false;
+      }
+    } else if (!strcmp(argv[i], "--data") && hasValue) {
+      opt.data = argv[++i];
+    } else if (!strcmp(argv[i], "--topic") && hasValue) {
+      opt.topics.push_back(argv[++i]);
+    } else if (!strcmp(argv[i], "--max-topics") && hasValue) {
+      opt.maxTopics = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--stats") && hasValue) {
+      opt.statsSeconds = atoi(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  if (opt.topics.empty()) {
+    opt.topics = sensorTopicFilters();
+  }
+  return opt.maxTopics > 0 && opt.statsSeconds > 0;
+}
+
+static void printStats(const TimeSeriesStore &store, const Ingestor &ingest,
+                       uint64_t &lastAccepted, int seconds) {
+  uint64_t samples = store.samplesAppended();
+  printf("ingest: %.0f samples/s, %llu stored, %llu ignored, %zu series, "
+         "%llu refused, %.2f bytes/sample\n",
+         (double)(ingest.accepted() - lastAccepted) / seconds,
+         (unsigned long long)ingest.accepted(),
+         (unsigned long long)ingest.ignored(), store.seriesCount(),
+         (unsigned long long)ingest.refused(),
+         samples ? (double)store.bytesAppended() / samples : 0.0);
+  fflush(stdout);
+  lastAccepted = ingest.accepted();
+}
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseArgs(argc, argv, opt)) {
+    fprintf(stderr,
+            "usage: %s [--broker HOST:PORT] [--data DIR] "
+            "[--topic FILTER]... [--max-topics N] [--stats SECONDS]\n",
+            argv[0]);
+    return 2;
+  }
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  TimeSeriesStore store;
+  if (!store.open(opt.data)) {
+    return 1;
+  }
+  Ingestor ingest(store, (size_t)opt.maxTopics);
+  printf("ingest: %zu series in %s\n", store.seriesCount(), opt.data.c_str());
+
+  MqttClient client;
+  MqttClient::MessageHandler onMessage = [&](const char *topic,
+                                             size_t topicLen,
+                                             const uint8_t *payload,
+                                             size_t payloadLen) {
+    ingest.handle(topic, topicLen, payload, payloadLen, realtimeMs());
+  };
+
+  int64_t nextRollup = 0, nextSync = 0;
+  int64_t nextStats = monotonicMs() + opt.statsSeconds * 1000LL;
+  uint64_t lastAccepted = 0;
+
+  while (!stopping) {
+    if (!client.connected()) {
+      bool ok = client.connect(opt.brokerHost, opt.brokerPort,
+                               "campus-ingest-" + std::to_string(getpid()));
+      for (size_t i = 0; ok && i < opt.topics.size(); i++) {
+        ok = client.subscribe(opt.topics[i]);
+      }
+      if (!ok) {
+        fprintf(stderr, "ingest: broker %s:%u unavailable, retrying\n",
+                opt.brokerHost.c_str(), opt.brokerPort);
+        client.disconnect();
+        sleep(RECONNECT_DELAY_S);
+        continue;
+      }
+      printf("ingest: connected to %s:%u\n", opt.brokerHost.c_str(),
+             opt.brokerPort);
+    }
+
+    client.poll(100, onMessage);
+
+    int64_t now = monotonicMs();
+    if (now >= nextRollup) {
+      store.rollup(realtimeMs());
+      nextRollup = now + ROLLUP_PERIOD_MS;
+    }
+    if (now >= nextSync) {
+      store.sync();
+      nextSync = now + SYNC_PERIOD_MS;
+    }
+    if (now >= nextStats) {
+      printStats(store, ingest, lastAccepted, opt.statsSeconds);
+      nextStats = now + opt.statsSeconds * 1000LL;
+    }
+  }
+
+  client.disconnect();
+  store.close();
+  printf("ingest: stopped\n");
+  return 0;
+}
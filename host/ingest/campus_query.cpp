@@ -0,0 +1,111 @@
+/*
+        Query the ingest daemon's store
+
+        Maps the store read-only, so it can run next to a live
+        campus_ingest and reads the same pages from the page
+        cache. Prints CSV on stdout.
+
+        Usage:
+          campus_query --data DIR --list
+          campus_query --data DIR METRIC [NODE]
+                       [--raw|--minute|--hour] [--last SECONDS]
+                       [--from MS --to MS]
+*/
+
+#include "Ingestor.hpp"
+#include "MqttClient.hpp"
+#include "TimeSeriesStore.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+enum Level { LEVEL_RAW, LEVEL_MINUTE, LEVEL_HOUR };
+
+int main(int argc, char **argv) {
+  std::string data = "tsdb", metric, node;
+  Level level = LEVEL_RAW;
+  int64_t from = LLONG_MIN, to = LLONG_MAX;
+  bool list = false;
+
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!strcmp(argv[i], "--data") && hasValue) {
+      data = argv[++i];
+    } else if (!strcmp(argv[i], "--list")) {
+      list = true;
+    } else if (!strcmp(argv[i], "--raw")) {
+      level = LEVEL_RAW;
+    } else if (!strcmp(argv[i], "--minute")) {
+      level = LEVEL_MINUTE;
+    } else if (!strcmp(argv[i], "--hour")) {
+      level = LEVEL_HOUR;
+    } else if (!strcmp(argv[i], "--last") && hasValue) {
+      from = realtimeMs() - atoll(argv[++i]) * 1000;
+    } else if (!strcmp(argv[i], "--from") && hasValue) {
+      from = atoll(argv[++i]);
+    } else if (!strcmp(argv[i], "--to") && hasValue) {
+      to = atoll(argv[++i]);
+    } else if (argv[i][0] != '-' && metric.empty()) {
+      metric = argv[i];
+    } else if (argv[i][0] != '-' && node.empty()) {
+      node = argv[i];
+    } else {
+      metric.clear();
+      list = false;
+      break;
+    }
+  }
+  if (!list && metric.empty()) {
+    fprintf(stderr,
+            "usage: %s --data DIR --list\n"
+            "       %s --data DIR METRIC [NODE] [--raw|--minute|--hour] "
+            "[--last SECONDS] [--from MS] [--to MS]\n",
+            argv[0], argv[0]);
+    return 2;
+  }
+
+  TimeSeriesStore store;
+  if (!store.open(data, true)) {
+    return 1;
+  }
+
+  if (list) {
+    for (const std::string &m : store.metrics()) {
+      for (const std::string &n : store.nodes(m)) {
+        printf("%s,%s\n", m.c_str(), n.c_str());
+      }
+    }
+    return 0;
+  }
+
+  int32_t series =
+      store.series(metric, node.empty() ? INGEST_DEFAULT_NODE : node);
+  if (series < 0) {
+    fprintf(stderr, "no series %s of node %s\n", metric.c_str(),
+            node.empty() ? INGEST_DEFAULT_NODE : node.c_str());
+    return 1;
+  }
+
+  if (level == LEVEL_RAW) {
+    printf("time_ms,value\n");
+    SampleCursor c = store.samples(series, from, to);
+    int64_t t;
+    float v;
+    while (c.next(t, v)) {
+      printf("%lld,%.2f\n", (long long)t, v);
+    }
+  } else {
+    printf("start_ms,min,max,avg,count\n");
+    store.rollups(series, level == LEVEL_MINUTE ? ROLLUP_MINUTE : ROLLUP_HOUR,
+                  from, to, [](const Rollup *r, size_t n) {
+                    for (size_t i = 0; i < n; i++) {
+                      printf("%lld,%.2f,%.2f,%.2f,%u\n", (long long)r[i].start,
+                             r[i].min, r[i].max, r[i].avg, r[i].count);
+                    }
+                  });
+  }
+  return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file AdaptiveSampler.hpp
+ * @brief Activity-Driven Sampling Interval Controller
+ *
+ * This module decides when a sensor should be read next. Instead of polling
+ * every sensor at one fixed interval, each sensor gets its own controller
+ * that:
+ * - drops to the sensor's minimum interval as soon as a reading moves by more
+ *   than a significance threshold, or recent readings are volatile;
+ * - holds the minimum interval for SAMPLER_BOOST_HOLD_MS when a related
+ *   event is reported through boost() (e.g. a door edge or presence change);
+ * - otherwise stretches the interval geometrically back to a slow baseline.
+ *
+ * Quiet rooms are therefore sampled (and published) rarely, while changes are
+ * followed closely. The minimum interval is never violated, which protects
+ * sensors such as the DHT11 that fail when read too often.
+ *
+ * @note The module has no Arduino dependencies and is also built on the host
+ */
+
+#ifndef ADAPTIVE_SAMPLER_H
+#define ADAPTIVE_SAMPLER_H
+
+#include <stdint.h>
+
+/**
+ * @defgroup AdaptiveSampler_Config Adaptive Sampler Configuration Constants
+ * @{
+ */
+
+/**
+ * @brief Interval growth factor applied after each quiet sample
+ *
+ * With 1.5 an interval climbs from 2 s back to a 60 s baseline in 9 quiet
+ * samples (about 3 minutes).
+ */
+#define SAMPLER_GROWTH 1.5f
+
+/**
+ * @brief Smoothing factor of the volatility estimate (0..1)
+ *
+ * The volatility is an exponentially weighted moving average of the rate of
+ * change, expressed as change per minimum interval. This is the weight of
+ * the newest rate when it spans one minimum interval; a reading after a
+ * longer gap weighs as much as that many readings would have, so the
+ * estimate decays with time rather than with the number of readings.
+ */
+#define SAMPLER_VOLATILITY_ALPHA 0.3f
+
+/**
+ * @brief How long boost() keeps a sensor at its minimum interval (ms)
+ *
+ * Related events usually come in bursts (several people walking in, the
+ * light switched on a few seconds after the door opened), so the fast rate
+ * is held for a while before it starts to decay.
+ */
+#define SAMPLER_BOOST_HOLD_MS 30000
+
+/** @} */
+
+/**
+ * @class AdaptiveSampler
+ * @brief Per-sensor sampling interval controller
+ *
+ * Typical use:
+ * @code
+ * AdaptiveSampler lux(1000, 60000, 20.0f);
+ * // in loop()
+ * if (lux.due(millis())) {
+ *   lux.record(computeLx(), millis());
+ * }
+ * // on a related event
+ * lux.boost(millis());
+ * @endcode
+ *
+ * Timestamps are millisecond counters such as millis(); wrap-around is
+ * handled by unsigned subtraction.
+ */
+class AdaptiveSampler {
+public:
+  /**
+   * @brief Construct a sampler for one sensor
+   *
+   * @param[in] minIntervalMs Shortest allowed time between two readings
+   * @param[in] baseIntervalMs Interval used when the signal is quiet
+   * @param[in] threshold Change (in sensor units) considered significant
+   *
+   * @note The first call to due() returns @c true so the sensor is read
+   * immediately after boot
+   */
+  AdaptiveSampler(uint32_t minIntervalMs, uint32_t baseIntervalMs,
+                  float threshold);
+
+  /**
+   * @brief Check whether the sensor should be read now
+   *
+   * @param[in] now Current time in milliseconds
+   *
+   * @return @c true if the current interval has elapsed since the last reading
+   */
+  bool due(uint32_t now) const;
+
+  /**
+   * @brief Record a new reading and adapt the interval
+   *
+   * @param[in] value Sensor reading
+   * @param[in] now Time of the reading in milliseconds
+   *
+   * @return @c true if the reading was classified as activity
+   */
+  bool record(float value, uint32_t now);
+
+  /**
+   * @brief Record a failed read attempt
+   *
+   * Restarts the current interval without touching the activity estimate,
+   * so a failing sensor is retried no faster than a working one is read.
+   *
+   * @param[in] now Time of the attempt in milliseconds
+   */
+  void missed(uint32_t now);
+
+  /**
+   * @brief Report a related event; sample at the minimum interval
+   *
+   * The next reading becomes due as soon as the minimum interval since the
+   * previous reading allows, and the interval stays at the minimum for
+   * SAMPLER_BOOST_HOLD_MS.
+   *
+   * @param[in] now Current time in milliseconds
+   */
+  void boost(uint32_t now);
+
+  /** @brief Current interval in milliseconds */
+  uint32_t interval() const;
+
+  /** @brief Time (milliseconds) at which the next reading is due */
+  uint32_t nextDue() const;
+
+private:
+  /** @brief Shortest allowed interval */
+  uint32_t minInterval;
+
+  /** @brief Quiet-state interval */
+  uint32_t baseInterval;
+
+  /** @brief Significant change in sensor units */
+  float threshold;
+
+  /** @brief Current interval */
+  float current;
+
+  /** @brief EWMA of absolute change per minimum interval */
+  float volatility;
+
+  /** @brief Previous reading */
+  float lastValue;
+
+  /** @brief Time of the previous reading */
+  uint32_t lastValueAt;
+
+  /** @brief Time of the previous reading or failed attempt */
+  uint32_t lastSample;
+
+  /** @brief Time of the last boost() */
+  uint32_t boostedAt;
+
+  /** @brief boost() hold in effect, cleared once it runs out */
+  bool holding;
+
+  /** @brief @c false until the first reading */
+  bool hasSample;
+
+  /** @brief @c false until the first reading or failed attempt */
+  bool started;
+};
+
+#endif // ADAPTIVE_SAMPLER_H
@@ -0,0 +1,222 @@
+/**
+ * @file MqttSn.hpp
+ * @brief MQTT-SN v1.2 Packet Encoder/Decoder
+ *
+ * This module serializes and parses the subset of MQTT for Sensor Networks
+ * (MQTT-SN) packets used by the Smart Campus nodes: CONNECT, REGISTER,
+ * PUBLISH, PINGREQ and DISCONNECT on the way out, and their acknowledgements
+ * on the way in. MQTT-SN runs over UDP and replaces topic strings with 2-byte
+ * topic IDs, which keeps a typical sensor PUBLISH under 16 bytes.
+ *
+ * The codec has no Arduino dependencies so the same code can be built on the
+ * host for benchmarking against a local MQTT-SN gateway.
+ *
+ * @note All functions write into a caller-provided buffer and never allocate
+ * @see https://www.oasis-open.org/committees/download.php/66091/MQTT-SN_spec_v1.2.pdf
+ */
+
+#ifndef MQTTSN_H
+#define MQTTSN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup MqttSn_Config MQTT-SN Protocol Constants
+ * @{
+ */
+
+/** @brief Default UDP port of an MQTT-SN gateway */
+#define MQTTSN_DEFAULT_PORT 10000
+
+/** @brief Protocol ID carried in the CONNECT packet */
+#define MQTTSN_PROTOCOL_ID 0x01
+
+/**
+ * @brief Largest packet the encoder will produce
+ *
+ * Packets up to 255 bytes use the 1-byte length header. Sensor payloads are a
+ * few characters, so the 3-byte extended header is never emitted.
+ */
+#define MQTTSN_MAX_PACKET 255
+
+/** @brief Topic ID type: ID assigned by the gateway through REGISTER */
+#define MQTTSN_TOPIC_NORMAL 0x00
+
+/** @brief Topic ID type: ID pre-configured on both client and gateway */
+#define MQTTSN_TOPIC_PREDEFINED 0x01
+
+/** @brief Topic ID type: 2-character topic name sent in place of an ID */
+#define MQTTSN_TOPIC_SHORT 0x02
+
+/** @brief Flags bit: retain the published message at the broker */
+#define MQTTSN_FLAG_RETAIN 0x10
+
+/** @brief Flags bit: request a clean session on CONNECT */
+#define MQTTSN_FLAG_CLEAN_SESSION 0x04
+
+/** @brief Return code: accepted */
+#define MQTTSN_RC_ACCEPTED 0x00
+
+/** @} */
+
+/**
+ * @brief MQTT-SN message type identifiers (subset used by this project)
+ */
+enum MqttSnMsgType : uint8_t {
+  MQTTSN_ADVERTISE = 0x00,
+  MQTTSN_SEARCHGW = 0x01,
+  MQTTSN_GWINFO = 0x02,
+  MQTTSN_CONNECT = 0x04,
+  MQTTSN_CONNACK = 0x05,
+  MQTTSN_REGISTER = 0x0A,
+  MQTTSN_REGACK = 0x0B,
+  MQTTSN_PUBLISH = 0x0C,
+  MQTTSN_PUBACK = 0x0D,
+  MQTTSN_PINGREQ = 0x16,
+  MQTTSN_PINGRESP = 0x17,
+  MQTTSN_DISCONNECT = 0x18,
+};
+
+/**
+ * @brief Decoded view of an incoming MQTT-SN packet
+ *
+ * Only the fields relevant to @ref type are filled in. @ref data points into
+ * the buffer passed to mqttsnParse() and is only valid while that buffer is.
+ */
+struct MqttSnPacket {
+  /** @brief One of ::MqttSnMsgType */
+  uint8_t type;
+
+  /** @brief Flags byte (PUBLISH only) */
+  uint8_t flags;
+
+  /** @brief Topic ID (REGISTER, REGACK, PUBLISH, PUBACK) */
+  uint16_t topicId;
+
+  /** @brief Message ID (REGISTER, REGACK, PUBLISH, PUBACK) */
+  uint16_t msgId;
+
+  /** @brief Sleep duration in seconds (DISCONNECT only) */
+  uint16_t duration;
+
+  /** @brief Return code (CONNACK, REGACK, PUBACK) */
+  uint8_t returnCode;
+
+  /** @brief Payload or topic name (PUBLISH, REGISTER) */
+  const uint8_t *data;
+
+  /** @brief Number of bytes at @ref data */
+  size_t dataLen;
+};
+
+/**
+ * @brief Encode a CONNECT packet
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] clientId NUL-terminated client identifier (1-23 characters)
+ * @param[in] keepAlive Keep-alive period in seconds
+ * @param[in] cleanSession Discard any session state held by the gateway
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small
+ */
+size_t mqttsnConnect(uint8_t *buf, size_t cap, const char *clientId,
+                     uint16_t keepAlive, bool cleanSession);
+
+/**
+ * @brief Encode a REGISTER packet asking the gateway for a topic ID
+ *
+ * Only needed for ::MQTTSN_TOPIC_NORMAL topics; predefined topics skip this
+ * round trip entirely.
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] msgId Message ID echoed back in the REGACK
+ * @param[in] topicName NUL-terminated topic name
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small
+ */
+size_t mqttsnRegister(uint8_t *buf, size_t cap, uint16_t msgId,
+                      const char *topicName);
+
+/**
+ * @brief Encode a PUBLISH packet
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] qos Quality of service: -1, 0 or 1
+ * @param[in] retain Ask the broker to retain the message
+ * @param[in] topicIdType One of MQTTSN_TOPIC_NORMAL, MQTTSN_TOPIC_PREDEFINED
+ *                        or MQTTSN_TOPIC_SHORT
+ * @param[in] topicId Topic ID (or two packed characters for short topics)
+ * @param[in] msgId Message ID; only meaningful for QoS 1, pass 0 otherwise
+ * @param[in] data Payload bytes
+ * @param[in] len Number of payload bytes
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small or @p qos is
+ * out of range
+ *
+ * @note QoS -1 is only valid with predefined or short topic IDs and does not
+ * require a connection to the gateway
+ */
+size_t mqttsnPublish(uint8_t *buf, size_t cap, int8_t qos, bool retain,
+                     uint8_t topicIdType, uint16_t topicId, uint16_t msgId,
+                     const uint8_t *data, size_t len);
+
+/**
+ * @brief Encode a PINGREQ packet
+ *
+ * A sleeping client includes its client ID to tell the gateway it is awake
+ * and ready to receive buffered messages; an active client passes @c nullptr.
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] clientId Client ID for wake-up, or @c nullptr for a keep-alive
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small
+ */
+size_t mqttsnPingReq(uint8_t *buf, size_t cap, const char *clientId);
+
+/**
+ * @brief Encode a DISCONNECT packet
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] sleepDuration Seconds the client intends to sleep, or 0 for a
+ *                          plain disconnect
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small
+ */
+size_t mqttsnDisconnect(uint8_t *buf, size_t cap, uint16_t sleepDuration);
+
+/**
+ * @brief Encode a PUBACK packet acknowledging a QoS 1 PUBLISH
+ *
+ * @param[out] buf Destination buffer
+ * @param[in] cap Capacity of @p buf in bytes
+ * @param[in] topicId Topic ID of the acknowledged PUBLISH
+ * @param[in] msgId Message ID of the acknowledged PUBLISH
+ * @param[in] returnCode Return code, normally MQTTSN_RC_ACCEPTED
+ *
+ * @return Number of bytes written, or 0 if @p buf is too small
+ */
+size_t mqttsnPubAck(uint8_t *buf, size_t cap, uint16_t topicId,
+                    uint16_t msgId, uint8_t returnCode);
+
+/**
+ * @brief Parse a received MQTT-SN packet
+ *
+ * Validates the length header against @p len and decodes the fields of the
+ * message types listed in ::MqttSnMsgType.
+ *
+ * @param[in] buf Received datagram
+ * @param[in] len Datagram length in bytes
+ * @param[out] out Decoded packet
+ *
+ * @return @c true if the packet is well-formed
+ * @return @c false if it is truncated or its length header is inconsistent
+ */
+bool mqttsnParse(const uint8_t *buf, size_t len, MqttSnPacket *out);
+
+#endif // MQTTSN_H
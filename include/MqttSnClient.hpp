@@ -0,0 +1,236 @@
+/**
+ * @file MqttSnClient.hpp
+ * @brief MQTT-SN Client over UDP for Sensor Nodes
+ *
+ * This module provides a small MQTT-SN client that publishes sensor values to
+ * an MQTT-SN gateway over UDP. The gateway (e.g. the Eclipse Paho MQTT-SN
+ * gateway) translates each packet into a regular MQTT PUBLISH towards the
+ * Mosquitto broker, so the rest of the backend is unaffected.
+ *
+ * Compared to PubSubClient over WiFiClient there is no TCP handshake, no
+ * head-of-line blocking after packet loss and no topic string in every packet:
+ * topics are addressed by pre-registered 2-byte topic IDs that must match the
+ * gateway's predefined topic list.
+ *
+ * Supported features:
+ * - QoS -1 (connectionless), QoS 0 and QoS 1 publishing
+ * - Keep-alive pings while connected
+ * - Sleeping client: DISCONNECT with a duration, wake-up via PINGREQ
+ *
+ * @note Not supported: subscriptions, QoS 2, will topics, gateway discovery
+ * @see MqttSn.hpp for the packet codec
+ */
+
+#ifndef MQTTSN_CLIENT_H
+#define MQTTSN_CLIENT_H
+
+#include "MqttSn.hpp"
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <Udp.h>
+
+/**
+ * @defgroup MqttSnClient_Config MQTT-SN Client Configuration Constants
+ * @{
+ */
+
+/**
+ * @brief Time to wait for an acknowledgement before retrying (ms)
+ *
+ * Corresponds to T_retry in the MQTT-SN specification.
+ */
+#define MQTTSN_RETRY_TIMEOUT 1000
+
+/**
+ * @brief Number of retransmissions before giving up
+ *
+ * Corresponds to N_retry in the MQTT-SN specification.
+ */
+#define MQTTSN_RETRY_COUNT 3
+
+/** @} */
+
+/**
+ * @class MqttSnClient
+ * @brief Publish-only MQTT-SN client bound to an Arduino UDP socket
+ *
+ * Typical use:
+ * @code
+ * WiFiUDP udp;
+ * MqttSnClient client(udp);
+ * client.setGateway(gatewayIp, MQTTSN_DEFAULT_PORT);
+ * client.connect("ESP32Client", 60);
+ * client.publish(1, "Open", 0);
+ * client.sleep(5);
+ * @endcode
+ *
+ * All blocking calls wait at most MQTTSN_RETRY_TIMEOUT per attempt and retry
+ * up to MQTTSN_RETRY_COUNT times, mirroring the retransmission rules of the
+ * specification.
+ */
+class MqttSnClient {
+public:
+  /**
+   * @brief Client state as seen by the gateway
+   */
+  enum State : uint8_t {
+    DISCONNECTED, ///< No session with the gateway
+    ACTIVE,       ///< Connected; keep-alive pings are sent from loop()
+    ASLEEP,       ///< Sleeping; gateway buffers messages for this client
+  };
+
+  /**
+   * @brief Construct a client bound to a UDP socket
+   *
+   * @param[in] udp UDP implementation (e.g. WiFiUDP); must outlive the client
+   *
+   * @note The socket is opened lazily by setGateway()
+   */
+  MqttSnClient(UDP &udp);
+
+  /**
+   * @brief Set the MQTT-SN gateway address and open the local socket
+   *
+   * @param[in] ip Gateway IP address
+   * @param[in] port Gateway UDP port, normally MQTTSN_DEFAULT_PORT
+   */
+  void setGateway(IPAddress ip, uint16_t port);
+
+  /**
+   * @brief Open a session with the gateway
+   *
+   * Sends CONNECT and waits for CONNACK. Calling connect() while ASLEEP
+   * resumes the existing session, as defined by the specification.
+   *
+   * @param[in] clientId Client identifier; also used for wake-up pings
+   * @param[in] keepAlive Keep-alive period in seconds
+   *
+   * @return @c true if the gateway accepted the connection
+   * @return @c false on timeout or rejection
+   *
+   * @post On success state() returns ACTIVE
+   */
+  bool connect(const char *clientId, uint16_t keepAlive);
+
+  /**
+   * @brief Publish a NUL-terminated payload to a predefined topic ID
+   *
+   * @param[in] topicId Predefined topic ID configured on the gateway
+   * @param[in] payload NUL-terminated payload string
+   * @param[in] qos -1, 0 or 1
+   *
+   * @return @c true if the packet was sent (QoS -1/0) or acknowledged (QoS 1)
+   * @return @c false on send failure, missing session or PUBACK timeout
+   *
+   * @note QoS -1 works in any state and needs no prior connect()
+   */
+  bool publish(uint16_t topicId, const char *payload, int8_t qos);
+
+  /**
+   * @brief Tell the gateway the client is going to sleep
+   *
+   * Sends DISCONNECT with @p duration and waits for the gateway to confirm.
+   * While asleep the gateway buffers messages for this client.
+   *
+   * @param[in] duration Expected sleep time in seconds
+   *
+   * @return @c true if the gateway acknowledged the sleep request
+   *
+   * @post On success state() returns ASLEEP
+   */
+  bool sleep(uint16_t duration);
+
+  /**
+   * @brief Briefly wake up to collect buffered messages
+   *
+   * Sends PINGREQ carrying the client ID and waits for PINGRESP, which the
+   * gateway sends after flushing buffered messages. The client stays ASLEEP.
+   *
+   * @return @c true if PINGRESP was received
+   */
+  bool wake();
+
+  /**
+   * @brief Close the session with the gateway
+   */
+  void disconnect();
+
+  /**
+   * @brief Service incoming packets and keep-alive pings
+   *
+   * Must be called regularly while ACTIVE, like PubSubClient::loop().
+   *
+   * @return @c true if the session is still ACTIVE
+   */
+  bool loop();
+
+  /** @brief @c true if state() is ACTIVE */
+  bool connected() const;
+
+  /** @brief Current client state */
+  State state() const;
+
+private:
+  /** @brief UDP socket used for all traffic */
+  UDP &udp;
+
+  /** @brief Gateway address */
+  IPAddress gatewayIp;
+
+  /** @brief Gateway UDP port */
+  uint16_t gatewayPort;
+
+  /** @brief Client identifier from the last connect() */
+  char clientId[24];
+
+  /** @brief Keep-alive period in milliseconds */
+  unsigned long keepAliveMs;
+
+  /** @brief Timestamp (millis()) of the last packet sent */
+  unsigned long lastSend;
+
+  /** @brief Next QoS 1 message ID */
+  uint16_t nextMsgId;
+
+  /** @brief Current state */
+  State current;
+
+  /** @brief Scratch buffer for outgoing and incoming packets */
+  uint8_t buf[MQTTSN_MAX_PACKET];
+
+  /**
+   * @brief Send @p len bytes of @ref buf to the gateway
+   *
+   * @return @c true if the datagram was handed to the network stack
+   */
+  bool send(size_t len);
+
+  /**
+   * @brief Wait for a packet of a given type
+   *
+   * Packets of other types are handled (PUBLISH is acknowledged, DISCONNECT
+   * ends the session) and otherwise dropped.
+   *
+   * @param[in] type Expected ::MqttSnMsgType
+   * @param[in] msgId Expected message ID, or 0 to accept any
+   * @param[out] out Decoded packet on success
+   *
+   * @return @c true if the packet arrived within MQTTSN_RETRY_TIMEOUT
+   */
+  bool waitFor(uint8_t type, uint16_t msgId, MqttSnPacket *out);
+
+  /**
+   * @brief Send @p len bytes and wait for a reply, retransmitting on timeout
+   *
+   * @return @c true if the reply arrived within MQTTSN_RETRY_COUNT attempts
+   */
+  bool request(size_t len, uint8_t replyType, uint16_t msgId,
+               MqttSnPacket *out);
+
+  /**
+   * @brief React to an unsolicited packet from the gateway
+   */
+  void handle(const MqttSnPacket &pkt);
+};
+
+#endif // MQTTSN_CLIENT_H
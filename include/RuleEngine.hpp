@@ -0,0 +1,219 @@
+/**
+ * @file RuleEngine.hpp
+ * @brief On-Device Alert Rule Engine
+ *
+ * This module evaluates alert rules such as "lights on in an empty room" or
+ * "door left open" directly on the node, so an alert can be published the
+ * moment a condition is met instead of after the next publish cycle and the
+ * backend round trip.
+ *
+ * Rules are written in a compact text format and compiled once, at startup,
+ * into a fixed-size table. Evaluation then touches a bounded number of table
+ * entries per tick (at most RULE_MAX_RULES x RULE_MAX_TERMS) and never
+ * allocates, so its cost is constant regardless of the rule text.
+ *
+ * Rule syntax, one rule per line (blank lines and lines starting with '#'
+ * are ignored):
+ * @code
+ * name : term [& term ...] [; debounce DURATION] [; cooldown DURATION]
+ * term : signal op number [for DURATION]
+ * op   : > | < | >= | <= | == | !=
+ * DURATION : number followed by s, m or h (e.g. 30s, 10m, 1h), up to 596h
+ * @endcode
+ *
+ * Example:
+ * @code
+ * lights_on_empty : lux > 300 & presence == 0 for 10m ; cooldown 15m
+ * door_left_open  : door == 1 for 5m ; cooldown 10m
+ * too_hot         : temperature > 28 ; debounce 60s ; cooldown 30m
+ * @endcode
+ *
+ * A term with @c for only counts as true once its comparison has held for
+ * that long. The whole rule must then hold for the debounce time before it
+ * fires, and it will not fire again until it has gone false and the cooldown
+ * since the last alert has passed.
+ *
+ * @note The module has no Arduino dependencies and is also built on the host
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup RuleEngine_Config Rule Engine Configuration Constants
+ * @{
+ */
+
+/** @brief Maximum number of rules in one table */
+#define RULE_MAX_RULES 16
+
+/** @brief Maximum number of AND-ed terms per rule */
+#define RULE_MAX_TERMS 4
+
+/** @brief Maximum rule name length, including the terminating NUL */
+#define RULE_NAME_LEN 24
+
+/** @} */
+
+/**
+ * @brief Inputs a rule can refer to
+ *
+ * Boolean inputs use 1 for true (door open, presence detected) and 0 for
+ * false. Names in the rule text are the lower-case names listed here.
+ */
+enum RuleSignal : uint8_t {
+  SIG_LUX,         ///< "lux": illuminance in lx (BH1750)
+  SIG_DOOR,        ///< "door": 1 if open
+  SIG_PRESENCE,    ///< "presence": 1 if someone is in the room
+  SIG_TEMPERATURE, ///< "temperature": degrees Celsius (DHT11)
+  SIG_HUMIDITY,    ///< "humidity": relative humidity in % (DHT11)
+  SIG_HEAT_INDEX,  ///< "heatindex": apparent temperature in Celsius
+  SIGNAL_COUNT
+};
+
+/**
+ * @brief Comparison operator of a rule term
+ */
+enum RuleOp : uint8_t { OP_GT, OP_LT, OP_GE, OP_LE, OP_EQ, OP_NE };
+
+/**
+ * @brief Callback invoked when a rule fires
+ *
+ * @param ruleName NUL-terminated rule name from the configuration
+ * @param now Timestamp passed to RuleEngine::evaluate()
+ */
+typedef void (*RuleAlertHandler)(const char *ruleName, uint32_t now);
+
+/**
+ * @class RuleEngine
+ * @brief Compiled rule table plus per-rule runtime state
+ *
+ * Typical use:
+ * @code
+ * RuleEngine rules;
+ * rules.compile(config);
+ * // on every new sample
+ * rules.update(SIG_LUX, lux, millis());
+ * // on every loop iteration
+ * rules.evaluate(millis(), publishAlert);
+ * @endcode
+ *
+ * Timestamps are millisecond counters such as millis(); wrap-around is
+ * handled by unsigned subtraction.
+ */
+class RuleEngine {
+public:
+  /**
+   * @brief Construct an empty engine with no rules
+   */
+  RuleEngine();
+
+  /**
+   * @brief Compile a rule configuration, replacing any previous rules
+   *
+   * @param[in] config NUL-terminated rule text (see file description)
+   * @param[out] error Optional buffer for a human-readable error message
+   * @param[in] errorLen Size of @p error in bytes
+   *
+   * @return @c true if every rule compiled
+   * @return @c false on a syntax error or when a limit is exceeded; the
+   * engine is left empty
+   */
+  bool compile(const char *config, char *error = nullptr, size_t errorLen = 0);
+
+  /**
+   * @brief Record a new sample for a signal
+   *
+   * Re-evaluates only the terms that reference @p signal. Signals that never
+   * received a sample make every term referencing them false.
+   *
+   * @param[in] signal One of ::RuleSignal
+   * @param[in] value New value
+   * @param[in] now Current time in milliseconds
+   */
+  void update(uint8_t signal, float value, uint32_t now);
+
+  /**
+   * @brief Evaluate all rules and report the ones that fire
+   *
+   * @param[in] now Current time in milliseconds
+   * @param[in] onAlert Called once for each rule that fires on this tick
+   *
+   * @return Number of rules that fired
+   */
+  uint8_t evaluate(uint32_t now, RuleAlertHandler onAlert);
+
+  /** @brief Number of compiled rules */
+  uint8_t ruleCount() const;
+
+  /** @brief Name of rule @p index, or @c nullptr if out of range */
+  const char *ruleName(uint8_t index) const;
+
+private:
+  /** @brief One compiled comparison */
+  struct Term {
+    uint8_t signal;
+    uint8_t op;
+    float threshold;
+    uint32_t holdMs;
+  };
+
+  /** @brief One compiled rule */
+  struct Rule {
+    char name[RULE_NAME_LEN];
+    uint8_t termCount;
+    Term terms[RULE_MAX_TERMS];
+    uint32_t debounceMs;
+    uint32_t cooldownMs;
+  };
+
+  /** @brief Compiled rule table */
+  Rule rules[RULE_MAX_RULES];
+
+  /** @brief Number of valid entries in @ref rules */
+  uint8_t count;
+
+  /**
+   * @brief Time each term's comparison became true
+   *
+   * Indexed [rule][term]; only meaningful while the matching bit of
+   * @ref termTrue is set.
+   */
+  uint32_t termSince[RULE_MAX_RULES][RULE_MAX_TERMS];
+
+  /** @brief Bit t of entry r is set while term t of rule r compares true */
+  uint8_t termTrue[RULE_MAX_RULES];
+
+  /** @brief Time each rule became true (all terms held) */
+  uint32_t ruleSince[RULE_MAX_RULES];
+
+  /** @brief Time each rule last fired */
+  uint32_t lastFired[RULE_MAX_RULES];
+
+  /** @brief Bit r set while rule r is true */
+  uint16_t ruleTrue;
+
+  /** @brief Bit r set once rule r fired and has not gone false since */
+  uint16_t ruleLatched;
+
+  /** @brief Bit r set once rule r has fired at least once */
+  uint16_t ruleEverFired;
+
+  /**
+   * @brief Terms referencing each signal, as rule * RULE_MAX_TERMS + term
+   *
+   * Lets update() touch only the affected terms.
+   */
+  uint8_t bySignal[SIGNAL_COUNT][RULE_MAX_RULES * RULE_MAX_TERMS];
+
+  /** @brief Number of valid entries in each @ref bySignal row */
+  uint8_t bySignalCount[SIGNAL_COUNT];
+
+  /** @brief Clear the rule table and all runtime state */
+  void reset();
+};
+
+#endif // RULE_ENGINE_H
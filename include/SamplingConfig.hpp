@@ -0,0 +1,50 @@
+/**
+ * @file SamplingConfig.hpp
+ * @brief Sampling Setup of the Sensor Node
+ *
+ * Intervals and thresholds of the per-sensor AdaptiveSampler instances in
+ * src/main.cpp. The host simulations (sampling_sim, fleet_loadgen) include
+ * this header so they model exactly what the firmware does.
+ *
+ * @note The module has no Arduino dependencies and is also built on the host
+ */
+
+#ifndef SAMPLING_CONFIG_H
+#define SAMPLING_CONFIG_H
+
+/**
+ * @defgroup SamplingConfig Sensor Node Sampling Constants
+ * @{
+ */
+
+/** @brief Interval every sensor backs off to while the room is quiet (ms) */
+#define SAMPLE_BASE_INTERVAL_MS 60000
+
+/**
+ * @brief Lux interval while the light level changes (ms)
+ *
+ * Well above BH1750_MIN_INTERVAL_MS; one second is enough to follow a light
+ * being switched.
+ */
+#define LUX_MIN_INTERVAL_MS 1000
+
+/**
+ * @brief Climate interval while temperature or humidity change (ms)
+ *
+ * Equal to DHT11_MIN_INTERVAL_MS, which is not used here because dht11.hpp
+ * needs Arduino.h; main.cpp checks that the two agree.
+ */
+#define CLIMATE_MIN_INTERVAL_MS 2000
+
+/** @brief Lux change (lx) that counts as activity */
+#define LUX_THRESHOLD 20.0f
+
+/** @brief Temperature change (degrees Celsius) that counts as activity */
+#define CLIMATE_THRESHOLD 1.0f
+
+/** @brief Humidity change (%RH) that also counts as climate activity */
+#define HUMIDITY_ACTIVITY 3.0f
+
+/** @} */
+
+#endif // SAMPLING_CONFIG_H
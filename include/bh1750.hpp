@@ -40,6 +40,14 @@
 /** @brief Expected number of bytes to read from I2C bus */
 #define EXPECTEDBYTES 2
 
+/**
+ * @brief Minimum time between two reads in RESMODEFREQ mode (ms)
+ *
+ * High-resolution mode needs up to 180ms per measurement; reading faster
+ * returns the previous result again.
+ */
+#define BH1750_MIN_INTERVAL_MS 180
+
 /**
  * @brief GPIO pin for I2C Serial Clock (SCL) on ESP32
  *
@@ -29,6 +29,16 @@
  */
 #define DHTPIN 4
 
+/**
+ * @brief Minimum time between two reads of the DHT11 (ms)
+ *
+ * The sensor returns stale or invalid data when polled faster than about
+ * once every 2 seconds. Schedulers must not read more often than this.
+ *
+ * @see getLastReadTime()
+ */
+#define DHT11_MIN_INTERVAL_MS 2000
+
 /** @} */
 
 /**
@@ -0,0 +1,95 @@
+/**
+ * @file mmWave.hpp
+ * @brief HMMD mmWave Presence Radar UART Interface
+ *
+ * This module drives the Waveshare HMMD 24GHz mmWave radar (S3KM1110) over
+ * the ESP32's second UART. The sensor is configured with a single command
+ * frame at start-up and can run in one of two output modes:
+ * - Normal mode: human-readable "ON"/"OFF"/"Range <cm>" text lines, read with
+ *   readAndProcessSensorLines()
+ * - Report mode: binary frames with the energy of every distance gate, read
+ *   with readMmWaveFrame() and processed by mmWaveProcessing.hpp
+ *
+ * @see mmWaveProcessing.hpp
+ */
+
+#ifndef MMWAVE_H
+#define MMWAVE_H
+
+#include "mmWaveProcessing.hpp"
+#include <Arduino.h>
+
+/**
+ * @defgroup mmWave_Config mmWave Configuration Constants
+ * @{
+ */
+
+/** @brief GPIO pin receiving data from the radar (ESP32 UART2 RX) */
+#define RX2_PIN 16
+
+/** @brief GPIO pin sending commands to the radar (ESP32 UART2 TX) */
+#define TX2_PIN 17
+
+/** @brief Prefix of the distance lines sent in normal mode */
+#define RANGE_PREFIX "Range "
+
+/** @brief Command selecting normal (text) output mode */
+#define MMWAVE_NORMAL_MODE_CMD "FDFCFBFA0800120000006400000004030201"
+
+/** @brief Command selecting report (per-gate energy) output mode */
+#define MMWAVE_REPORT_MODE_CMD "FDFCFBFA0800120000000400000004030201"
+
+/**
+ * @brief Maximum bytes consumed per readMmWaveFrame() call
+ *
+ * Bounds the time spent in one call so loop() stays responsive even if the
+ * UART buffer has filled up.
+ */
+#define MMWAVE_MAX_BYTES_PER_CALL 256
+
+/** @} */
+
+/**
+ * @brief Send a command frame given as a hex string
+ *
+ * @param[in] hexString Command bytes as hex digits, e.g. "FDFC..."
+ *
+ * @note Prints the bytes sent on Serial for debugging
+ */
+void sendHexData(String hexString);
+
+/**
+ * @brief Read the latest distance in normal mode
+ *
+ * Drains the text lines buffered by the sensor and returns the distance of
+ * the first "Range" line found.
+ *
+ * @return Distance in cm
+ * @retval -1 if no range line was available
+ *
+ * @pre init_mmWave() was called with @p reportMode = @c false
+ */
+int readAndProcessSensorLines();
+
+/**
+ * @brief Initialise the radar UART and select the output mode
+ *
+ * @param[in] reportMode @c true for binary per-gate report frames,
+ *                       @c false for normal text output
+ */
+void init_mmWave(bool reportMode = false);
+
+/**
+ * @brief Read report-mode bytes until a frame is complete
+ *
+ * Consumes at most MMWAVE_MAX_BYTES_PER_CALL bytes from the radar UART.
+ *
+ * @param[in,out] parser Frame parser holding partial frames between calls
+ *
+ * @return @c true if a new frame is available through parser.frame()
+ *
+ * @pre init_mmWave() was called with @p reportMode = @c true
+ */
+bool readMmWaveFrame(MmWaveFrameParser &parser);
+
+#endif // MMWAVE_H
@@ -0,0 +1,261 @@
+/**
+ * @file mmWaveProcessing.hpp
+ * @brief mmWave Report-Mode Frame Parser and Per-Gate Energy Processing
+ *
+ * In report mode the HMMD (S3KM1110) radar streams binary frames carrying the
+ * reflected energy of each of its distance gates (0.7 m apart) instead of a
+ * single "Range" text line. This module turns that stream into occupancy
+ * information:
+ * - MmWaveFrameParser: byte-at-a-time state machine producing fixed-size
+ *   frames, constant memory, resynchronises on garbage
+ * - MmWaveProcessor: per-gate kernels (temporal smoothing, background
+ *   subtraction, per-gate thresholds) producing presence, a moving/stationary
+ *   split and a coarse target count
+ *
+ * Report frame layout (little-endian):
+ * @code
+ * F4 F3 F2 F1 | len (2) | detected (1) | distance cm (2) | energy[16] | F8 F7 F6 F5
+ * @endcode
+ * Each energy is 2 or 4 bytes depending on firmware; the width is derived from
+ * @c len.
+ *
+ * The sensor only reports total energy per gate, so motion is separated from
+ * stationary presence by its time behaviour: energy that fluctuates from frame
+ * to frame is moving, energy that stays above the empty-room background is
+ * static (a seated, breathing person).
+ *
+ * All per-gate work runs over fixed MMWAVE_GATES-element float arrays in
+ * branch-free loops the compiler can vectorise, so processing time per frame
+ * is constant.
+ *
+ * @note The module has no Arduino dependencies and is also built on the host
+ */
+
+#ifndef MMWAVE_PROCESSING_H
+#define MMWAVE_PROCESSING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @defgroup mmWaveProcessing_Config mmWave Processing Configuration Constants
+ * @{
+ */
+
+/** @brief Number of distance gates reported by the sensor */
+#define MMWAVE_GATES 16
+
+/** @brief Largest report frame accepted (4-byte energies) */
+#define MMWAVE_MAX_FRAME (4 + 2 + 3 + MMWAVE_GATES * 4 + 4)
+
+/** @brief Smoothing factor of the short (fast) energy average */
+#define MMWAVE_ALPHA_SHORT 0.5f
+
+/** @brief Smoothing factor of the long (slow) energy average */
+#define MMWAVE_ALPHA_LONG 0.05f
+
+/** @brief Smoothing factor of background and noise while the room is empty */
+#define MMWAVE_ALPHA_BACKGROUND 0.01f
+
+/**
+ * @brief Frames used to learn the background after start-up
+ *
+ * The room must be empty for this many consecutive frames (5 s at the
+ * sensor's 100 ms frame period). Calibration starts over whenever the
+ * sensor's own detection flag is set, so a node booted in an occupied room
+ * waits until the room is empty. Afterwards the background only adapts
+ * while no presence is detected.
+ */
+#define MMWAVE_CALIBRATION_FRAMES 50
+
+/** @brief Moving threshold, in multiples of the gate's noise level */
+#define MMWAVE_MOVING_K 4.0f
+
+/** @brief Static threshold, in multiples of the gate's noise level */
+#define MMWAVE_STATIC_K 3.0f
+
+/**
+ * @brief Frames presence is held after the last detection
+ *
+ * Bridges short gaps while a person sits perfectly still.
+ */
+#define MMWAVE_HOLD_FRAMES 30
+
+/** @} */
+
+/**
+ * @brief One decoded report frame
+ */
+struct MmWaveFrame {
+  /** @brief Sensor's own presence decision */
+  bool detected;
+
+  /** @brief Sensor's target distance in cm */
+  uint16_t distance;
+
+  /** @brief Reflected energy per distance gate */
+  float energy[MMWAVE_GATES];
+};
+
+/**
+ * @brief Occupancy derived from one processed frame
+ */
+struct MmWaveResult {
+  /** @brief Someone is in the room (moving, stationary or held) */
+  bool presence;
+
+  /** @brief At least one gate shows motion */
+  bool moving;
+
+  /** @brief Present but no gate shows motion */
+  bool stationary;
+
+  /**
+   * @brief Coarse number of people
+   *
+   * Number of separate groups of adjacent active gates. People closer than
+   * one gate apart count as one.
+   */
+  uint8_t targets;
+
+  /** @brief Bit g set if gate g is active (moving or static) */
+  uint16_t activeGates;
+
+  /** @brief Bit g set if gate g shows motion */
+  uint16_t movingGates;
+};
+
+/**
+ * @class MmWaveFrameParser
+ * @brief Streaming parser for report-mode frames
+ *
+ * Feed every byte read from the sensor's UART; feed() returns @c true when a
+ * complete, well-formed frame is available through frame().
+ */
+class MmWaveFrameParser {
+public:
+  MmWaveFrameParser();
+
+  /**
+   * @brief Consume one byte from the sensor
+   *
+   * @param[in] b Received byte
+   *
+   * @return @c true if @p b completed a valid frame
+   */
+  bool feed(uint8_t b);
+
+  /**
+   * @brief Consume a buffer, stopping after the first complete frame
+   *
+   * @param[in] data Received bytes
+   * @param[in] len Number of bytes at @p data
+   * @param[out] used Number of bytes consumed
+   *
+   * @return @c true if a frame was completed
+   */
+  bool feed(const uint8_t *data, size_t len, size_t *used);
+
+  /** @brief Most recently completed frame */
+  const MmWaveFrame &frame() const;
+
+  /** @brief Frames rejected because of a bad length or trailer */
+  uint32_t errors() const;
+
+private:
+  /** @brief Bytes of the frame being assembled */
+  uint8_t buf[MMWAVE_MAX_FRAME];
+
+  /** @brief Number of valid bytes in @ref buf */
+  uint16_t pos;
+
+  /** @brief Expected total frame size once the length field is known */
+  uint16_t expected;
+
+  /** @brief Last completed frame */
+  MmWaveFrame current;
+
+  /** @brief Rejected frame counter */
+  uint32_t rejected;
+
+  /** @brief Decode @ref buf into @ref current */
+  bool decode();
+};
+
+/**
+ * @class MmWaveProcessor
+ * @brief Per-gate energy processing pipeline
+ *
+ * Keeps per-gate state in fixed arrays:
+ * @code
+ * short   = EMA(energy, MMWAVE_ALPHA_SHORT)        temporal smoothing
+ * long    = EMA(energy, MMWAVE_ALPHA_LONG)
+ * moving  = |short - long|                         fluctuation
+ * static  = max(long - background, 0)              background subtraction
+ * active  = moving > kM * noise  |  static > kS * noise + offset
+ * @endcode
+ * Background and noise are learnt during calibration and whenever the room
+ * is empty.
+ */
+class MmWaveProcessor {
+public:
+  MmWaveProcessor();
+
+  /**
+   * @brief Process one frame
+   *
+   * @param[in] frame Decoded report frame
+   * @param[out] out Occupancy for this frame
+   */
+  void process(const MmWaveFrame &frame, MmWaveResult *out);
+
+  /**
+   * @brief Set an extra static threshold for one gate
+   *
+   * Useful to mask gates that see a fan, a radiator or a wall reflection.
+   *
+   * @param[in] gate Gate index (0 to MMWAVE_GATES - 1)
+   * @param[in] offset Energy added to the gate's static threshold
+   */
+  void setStaticOffset(uint8_t gate, float offset);
+
+  /**
+   * @brief Restart background calibration
+   *
+   * The next MMWAVE_CALIBRATION_FRAMES frames without the sensor's own
+   * detection become the new empty-room background.
+   */
+  void recalibrate();
+
+  /**
+   * @brief @c true while the background is still being learnt
+   *
+   * No occupancy is reported until calibration is done, which may take
+   * indefinitely long if the room is never empty.
+   */
+  bool calibrating() const;
+
+private:
+  /** @brief Short and long moving averages of the energy */
+  float shortAvg[MMWAVE_GATES];
+  float longAvg[MMWAVE_GATES];
+
+  /** @brief Empty-room energy and its typical deviation */
+  float background[MMWAVE_GATES];
+  float noise[MMWAVE_GATES];
+
+  /** @brief Per-gate static threshold offsets */
+  float staticOffset[MMWAVE_GATES];
+
+  /** @brief Kernel outputs of the last frame */
+  float movingEnergy[MMWAVE_GATES];
+  float staticEnergy[MMWAVE_GATES];
+
+  /** @brief Frames processed since (re)calibration started */
+  uint32_t frames;
+
+  /** @brief Frames left before presence is released */
+  uint16_t hold;
+};
+
+#endif // MMWAVE_PROCESSING_H
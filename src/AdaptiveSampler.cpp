@@ -0,0 +1,85 @@
+#include "../include/AdaptiveSampler.hpp"
+
+#include <math.h>
+
+AdaptiveSampler::AdaptiveSampler(uint32_t minIntervalMs,
+                                 uint32_t baseIntervalMs, float threshold)
+    : minInterval(minIntervalMs > 0 ? minIntervalMs : 1),
+      baseInterval(baseIntervalMs > minIntervalMs ? baseIntervalMs
+                                                  : minIntervalMs),
+      threshold(threshold), current((float)baseInterval), volatility(0),
+      lastValue(0), lastValueAt(0), lastSample(0), boostedAt(0),
+      holding(false), hasSample(false), started(false) {}
+
+bool AdaptiveSampler::due(uint32_t now) const {
+  return !started || now - lastSample >= (uint32_t)current;
+}
+
+/*
+        A reading counts as activity if it moved by at least
+        the threshold since the previous one, or if the smoothed
+        rate of change is at least half the threshold per
+        minimum interval (several smaller steps in a row).
+        Activity snaps the interval to the minimum; quiet
+        readings stretch it.
+
+        The rate is normalised by the time since the previous
+        reading, so a slow drift does not look volatile just
+        because the sampler has backed off and sees it in large
+        steps, and the average forgets at the same speed in time
+        whatever the interval.
+*/
+bool AdaptiveSampler::record(float value, uint32_t now) {
+  bool active = false;
+
+  if (hasSample) {
+    float delta = fabsf(value - lastValue);
+    float steps = (float)(now - lastValueAt) / (float)minInterval;
+    if (steps < 1.0f) {
+      steps = 1.0f;
+    }
+    float alpha = 1.0f - powf(1.0f - SAMPLER_VOLATILITY_ALPHA, steps);
+    volatility += alpha * (delta / steps - volatility);
+    active = delta >= threshold || volatility >= 0.5f * threshold;
+  }
+
+  // Elapsed time rather than a deadline, so millis() wrap-around cannot
+  // re-arm an expired hold
+  if (holding && now - boostedAt >= SAMPLER_BOOST_HOLD_MS) {
+    holding = false;
+  }
+
+  if (active || holding) {
+    current = (float)minInterval;
+  } else {
+    current *= SAMPLER_GROWTH;
+    if (current > (float)baseInterval) {
+      current = (float)baseInterval;
+    }
+  }
+
+  lastValue = value;
+  lastValueAt = now;
+  lastSample = now;
+  hasSample = true;
+  started = true;
+  return active;
+}
+
+void AdaptiveSampler::missed(uint32_t now) {
+  lastSample = now;
+  started = true;
+}
+
+void AdaptiveSampler::boost(uint32_t now) {
+  // due() measures from the last reading, so the minimum interval holds
+  current = (float)minInterval;
+  boostedAt = now;
+  holding = true;
+}
+
+uint32_t AdaptiveSampler::interval() const { return (uint32_t)current; }
+
+uint32_t AdaptiveSampler::nextDue() const {
+  return lastSample + (uint32_t)current;
+}
@@ -0,0 +1,211 @@
+#include "../include/MqttSn.hpp"
+
+#include <string.h>
+
+// Write a 16-bit value in network byte order (MSB first)
+static inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)(v >> 8);
+  p[1] = (uint8_t)(v & 0xFF);
+}
+
+static inline uint16_t get16(const uint8_t *p) {
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+/*
+        Every MQTT-SN packet starts with Length and MsgType. The
+        length covers the whole packet, header included. We only
+        ever produce short packets, so Length is a single byte.
+*/
+static size_t putHeader(uint8_t *buf, size_t cap, size_t total,
+                        uint8_t type) {
+  if (total > cap || total > MQTTSN_MAX_PACKET) {
+    return 0;
+  }
+  buf[0] = (uint8_t)total;
+  buf[1] = type;
+  return 2;
+}
+
+size_t mqttsnConnect(uint8_t *buf, size_t cap, const char *clientId,
+                     uint16_t keepAlive, bool cleanSession) {
+  size_t idLen = strlen(clientId);
+  size_t total = 6 + idLen;
+
+  if (!putHeader(buf, cap, total, MQTTSN_CONNECT)) {
+    return 0;
+  }
+  buf[2] = cleanSession ? MQTTSN_FLAG_CLEAN_SESSION : 0;
+  buf[3] = MQTTSN_PROTOCOL_ID;
+  put16(buf + 4, keepAlive);
+  memcpy(buf + 6, clientId, idLen);
+
+  return total;
+}
+
+size_t mqttsnRegister(uint8_t *buf, size_t cap, uint16_t msgId,
+                      const char *topicName) {
+  size_t nameLen = strlen(topicName);
+  size_t total = 6 + nameLen;
+
+  if (!putHeader(buf, cap, total, MQTTSN_REGISTER)) {
+    return 0;
+  }
+  put16(buf + 2, 0x0000); // TopicId is unused from client to gateway
+  put16(buf + 4, msgId);
+  memcpy(buf + 6, topicName, nameLen);
+
+  return total;
+}
+
+size_t mqttsnPublish(uint8_t *buf, size_t cap, int8_t qos, bool retain,
+                     uint8_t topicIdType, uint16_t topicId, uint16_t msgId,
+                     const uint8_t *data, size_t len) {
+  uint8_t qosBits;
+
+  // QoS lives in bits 6..5 of the flags byte; 0b11 is QoS -1
+  switch (qos) {
+  case -1:
+    qosBits = 0x60;
+    break;
+  case 0:
+    qosBits = 0x00;
+    break;
+  case 1:
+    qosBits = 0x20;
+    break;
+  default:
+    return 0;
+  }
+
+  size_t total = 7 + len;
+  if (!putHeader(buf, cap, total, MQTTSN_PUBLISH)) {
+    return 0;
+  }
+  buf[2] = qosBits | (retain ? MQTTSN_FLAG_RETAIN : 0) | (topicIdType & 0x03);
+  put16(buf + 3, topicId);
+  put16(buf + 5, qos == 1 ? msgId : 0);
+  memcpy(buf + 7, data, len);
+
+  return total;
+}
+
+size_t mqttsnPingReq(uint8_t *buf, size_t cap, const char *clientId) {
+  size_t idLen = clientId ? strlen(clientId) : 0;
+  size_t total = 2 + idLen;
+
+  if (!putHeader(buf, cap, total, MQTTSN_PINGREQ)) {
+    return 0;
+  }
+  if (idLen) {
+    memcpy(buf + 2, clientId, idLen);
+  }
+
+  return total;
+}
+
+size_t mqttsnDisconnect(uint8_t *buf, size_t cap, uint16_t sleepDuration) {
+  size_t total = sleepDuration ? 4 : 2;
+
+  if (!putHeader(buf, cap, total, MQTTSN_DISCONNECT)) {
+    return 0;
+  }
+  if (sleepDuration) {
+    put16(buf + 2, sleepDuration);
+  }
+
+  return total;
+}
+
+size_t mqttsnPubAck(uint8_t *buf, size_t cap, uint16_t topicId,
+                    uint16_t msgId, uint8_t returnCode) {
+  if (!putHeader(buf, cap, 7, MQTTSN_PUBACK)) {
+    return 0;
+  }
+  put16(buf + 2, topicId);
+  put16(buf + 4, msgId);
+  buf[6] = returnCode;
+
+  return 7;
+}
+
+bool mqttsnParse(const uint8_t *buf, size_t len, MqttSnPacket *out) {
+  size_t hdr;
+  size_t total;
+
+  // Length is one byte, or 0x01 followed by a 16-bit length
+  if (len < 2) {
+    return false;
+  }
+  if (buf[0] == 0x01) {
+    if (len < 4) {
+      return false;
+    }
+    total = get16(buf + 1);
+    hdr = 4;
+  } else {
+    total = buf[0];
+    hdr = 2;
+  }
+  if (total < hdr || total > len) {
+    return false;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->type = buf[hdr - 1];
+
+  const uint8_t *body = buf + hdr;
+  size_t bodyLen = total - hdr;
+
+  switch (out->type) {
+  case MQTTSN_CONNACK:
+    if (bodyLen < 1) {
+      return false;
+    }
+    out->returnCode = body[0];
+    break;
+
+  case MQTTSN_REGISTER:
+    if (bodyLen < 4) {
+      return false;
+    }
+    out->topicId = get16(body);
+    out->msgId = get16(body + 2);
+    out->data = body + 4;
+    out->dataLen = bodyLen - 4;
+    break;
+
+  case MQTTSN_REGACK:
+  case MQTTSN_PUBACK:
+    if (bodyLen < 5) {
+      return false;
+    }
+    out->topicId = get16(body);
+    out->msgId = get16(body + 2);
+    out->returnCode = body[4];
+    break;
+
+  case MQTTSN_PUBLISH:
+    if (bodyLen < 5) {
+      return false;
+    }
+    out->flags = body[0];
+    out->topicId = get16(body + 1);
+    out->msgId = get16(body + 3);
+    out->data = body + 5;
+    out->dataLen = bodyLen - 5;
+    break;
+
+  case MQTTSN_DISCONNECT:
+    if (bodyLen >= 2) {
+      out->duration = get16(body);
+    }
+    break;
+
+  default:
+    // PINGREQ/PINGRESP and gateway discovery carry nothing we use
+    break;
+  }
+
+  return true;
+}
@@ -0,0 +1,190 @@
+#include "../include/MqttSnClient.hpp"
+
+MqttSnClient::MqttSnClient(UDP &udp)
+    : udp(udp), gatewayPort(MQTTSN_DEFAULT_PORT), clientId{0},
+      keepAliveMs(0), lastSend(0), nextMsgId(1), current(DISCONNECTED) {}
+
+void MqttSnClient::setGateway(IPAddress ip, uint16_t port) {
+  gatewayIp = ip;
+  gatewayPort = port;
+  // Fixed local port so QoS -1 nodes can be listed in the gateway's
+  // clients.conf by address
+  udp.begin(MQTTSN_DEFAULT_PORT);
+}
+
+bool MqttSnClient::send(size_t len) {
+  if (len == 0) {
+    return false;
+  }
+  udp.beginPacket(gatewayIp, gatewayPort);
+  udp.write(buf, len);
+  if (!udp.endPacket()) {
+    return false;
+  }
+  lastSend = millis();
+  return true;
+}
+
+void MqttSnClient::handle(const MqttSnPacket &pkt) {
+  switch (pkt.type) {
+  case MQTTSN_PUBLISH:
+    // Acknowledge QoS 1 deliveries so the gateway stops retrying
+    if ((pkt.flags & 0x60) == 0x20) {
+      send(mqttsnPubAck(buf, sizeof(buf), pkt.topicId, pkt.msgId,
+                        MQTTSN_RC_ACCEPTED));
+    }
+    break;
+  case MQTTSN_DISCONNECT:
+    // Gateway dropped the session (e.g. keep-alive expired)
+    current = DISCONNECTED;
+    break;
+  default:
+    break;
+  }
+}
+
+bool MqttSnClient::waitFor(uint8_t type, uint16_t msgId, MqttSnPacket *out) {
+  unsigned long start = millis();
+  uint8_t rx[MQTTSN_MAX_PACKET];
+
+  while (millis() - start < MQTTSN_RETRY_TIMEOUT) {
+    int len = udp.parsePacket();
+    if (len <= 0) {
+      delay(1);
+      continue;
+    }
+    len = udp.read(rx, sizeof(rx));
+    if (len <= 0 || !mqttsnParse(rx, (size_t)len, out)) {
+      continue;
+    }
+    if (out->type == type && (msgId == 0 || out->msgId == msgId)) {
+      return true;
+    }
+    handle(*out);
+  }
+  return false;
+}
+
+bool MqttSnClient::request(size_t len, uint8_t replyType, uint16_t msgId,
+                           MqttSnPacket *out) {
+  // buf is reused by handle(), so keep a copy for retransmission
+  uint8_t pkt[MQTTSN_MAX_PACKET];
+  memcpy(pkt, buf, len);
+
+  for (int attempt = 0; attempt <= MQTTSN_RETRY_COUNT; attempt++) {
+    memcpy(buf, pkt, len);
+    if (attempt > 0 && pkt[1] == MQTTSN_PUBLISH) {
+      buf[2] |= 0x80; // Set DUP on retransmitted PUBLISH
+    }
+    if (send(len) && waitFor(replyType, msgId, out)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool MqttSnClient::connect(const char *id, uint16_t keepAlive) {
+  MqttSnPacket reply;
+
+  strncpy(clientId, id, sizeof(clientId) - 1);
+  clientId[sizeof(clientId) - 1] = '\0';
+  keepAliveMs = (unsigned long)keepAlive * 1000UL;
+
+  // Keep the session when resuming from sleep
+  size_t len =
+      mqttsnConnect(buf, sizeof(buf), clientId, keepAlive, current != ASLEEP);
+  if (!request(len, MQTTSN_CONNACK, 0, &reply) ||
+      reply.returnCode != MQTTSN_RC_ACCEPTED) {
+    current = DISCONNECTED;
+    return false;
+  }
+
+  current = ACTIVE;
+  return true;
+}
+
+bool MqttSnClient::publish(uint16_t topicId, const char *payload, int8_t qos) {
+  if (qos >= 0 && current != ACTIVE) {
+    return false;
+  }
+
+  uint16_t msgId = 0;
+  if (qos == 1) {
+    msgId = nextMsgId++;
+    if (nextMsgId == 0) {
+      nextMsgId = 1; // Message ID 0 is reserved
+    }
+  }
+
+  size_t len = mqttsnPublish(buf, sizeof(buf), qos, false,
+                             MQTTSN_TOPIC_PREDEFINED, topicId, msgId,
+                             (const uint8_t *)payload, strlen(payload));
+  if (qos < 1) {
+    return send(len);
+  }
+
+  MqttSnPacket ack;
+  return request(len, MQTTSN_PUBACK, msgId, &ack) &&
+         ack.returnCode == MQTTSN_RC_ACCEPTED;
+}
+
+bool MqttSnClient::sleep(uint16_t duration) {
+  MqttSnPacket reply;
+
+  if (current != ACTIVE) {
+    return false;
+  }
+  if (!request(mqttsnDisconnect(buf, sizeof(buf), duration),
+               MQTTSN_DISCONNECT, 0, &reply)) {
+    return false;
+  }
+
+  current = ASLEEP;
+  return true;
+}
+
+bool MqttSnClient::wake() {
+  MqttSnPacket reply;
+
+  if (current != ASLEEP) {
+    return false;
+  }
+  return request(mqttsnPingReq(buf, sizeof(buf), clientId), MQTTSN_PINGRESP,
+                 0, &reply);
+}
+
+void MqttSnClient::disconnect() {
+  if (current != DISCONNECTED) {
+    send(mqttsnDisconnect(buf, sizeof(buf), 0));
+  }
+  current = DISCONNECTED;
+}
+
+bool MqttSnClient::loop() {
+  uint8_t rx[MQTTSN_MAX_PACKET];
+  MqttSnPacket pkt;
+
+  // Drain whatever the gateway sent since the last call
+  int len;
+  while ((len = udp.parsePacket()) > 0) {
+    len = udp.read(rx, sizeof(rx));
+    if (len > 0 && mqttsnParse(rx, (size_t)len, &pkt)) {
+      handle(pkt);
+    }
+  }
+
+  // Send a keep-alive ping if nothing else went out for a whole period
+  if (current == ACTIVE && keepAliveMs > 0 &&
+      millis() - lastSend >= keepAliveMs) {
+    if (!request(mqttsnPingReq(buf, sizeof(buf), nullptr), MQTTSN_PINGRESP, 0,
+                 &pkt)) {
+      current = DISCONNECTED;
+    }
+  }
+
+  return current == ACTIVE;
+}
+
+bool MqttSnClient::connected() const { return current == ACTIVE; }
+
+MqttSnClient::State MqttSnClient::state() const { return current; }
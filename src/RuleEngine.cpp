@@ -0,0 +1,324 @@
+#include "../include/RuleEngine.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Names used in the rule text, indexed by RuleSignal
+static const char *const signalNames[SIGNAL_COUNT] = {
+    "lux", "door", "presence", "temperature", "humidity", "heatindex",
+};
+
+/*
+        Small cursor over the configuration text. Every parse
+        helper skips leading blanks, consumes what it recognises
+        and returns false (leaving an error message) otherwise.
+*/
+struct Cursor {
+  const char *p;
+  int line;
+  char *error;
+  size_t errorLen;
+};
+
+static bool fail(Cursor &c, const char *what) {
+  if (c.error && c.errorLen) {
+    snprintf(c.error, c.errorLen, "line %d: %s", c.line, what);
+  }
+  return false;
+}
+
+static void skipBlanks(Cursor &c) {
+  while (*c.p == ' ' || *c.p == '\t' || *c.p == '\r') {
+    c.p++;
+  }
+}
+
+static bool atLineEnd(Cursor &c) {
+  skipBlanks(c);
+  return *c.p == '\0' || *c.p == '\n';
+}
+
+static bool accept(Cursor &c, const char *token) {
+  skipBlanks(c);
+  size_t n = strlen(token);
+  if (strncmp(c.p, token, n) != 0) {
+    return false;
+  }
+  c.p += n;
+  return true;
+}
+
+static bool isWordChar(char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+         (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+static size_t word(Cursor &c, const char **start) {
+  skipBlanks(c);
+  *start = c.p;
+  while (isWordChar(*c.p)) {
+    c.p++;
+  }
+  return (size_t)(c.p - *start);
+}
+
+static bool number(Cursor &c, float *out) {
+  skipBlanks(c);
+  char *end;
+  *out = strtof(c.p, &end);
+  if (end == c.p || !isfinite(*out)) {
+    return fail(c, "expected a number");
+  }
+  c.p = end;
+  return true;
+}
+
+// A duration is a number with an s, m or h suffix, e.g. 30s or 10m. The
+// timing checks use unsigned differences of millis(), which are only
+// meaningful up to INT32_MAX, so longer durations are rejected.
+static bool duration(Cursor &c, uint32_t *ms) {
+  float value;
+  if (!number(c, &value) || value < 0) {
+    return fail(c, "expected a duration");
+  }
+  float scale;
+  switch (*c.p) {
+  case 's':
+    scale = 1000.0f;
+    break;
+  case 'm':
+    scale = 60000.0f;
+    break;
+  case 'h':
+    scale = 3600000.0f;
+    break;
+  default:
+    return fail(c, "duration needs an s, m or h suffix");
+  }
+  c.p++;
+  double total = (double)value * scale;
+  if (total > INT32_MAX) {
+    return fail(c, "duration too long (max 596h)");
+  }
+  *ms = (uint32_t)total;
+  return true;
+}
+
+// Two-character operators must be tried before their one-character prefixes
+static bool comparison(Cursor &c, uint8_t *op) {
+  if (accept(c, ">=")) {
+    *op = OP_GE;
+  } else if (accept(c, "<=")) {
+    *op = OP_LE;
+  } else if (accept(c, "==")) {
+    *op = OP_EQ;
+  } else if (accept(c, "!=")) {
+    *op = OP_NE;
+  } else if (accept(c, ">")) {
+    *op = OP_GT;
+  } else if (accept(c, "<")) {
+    *op = OP_LT;
+  } else {
+    return fail(c, "expected one of > < >= <= == !=");
+  }
+  return true;
+}
+
+static bool compare(uint8_t op, float value, float threshold) {
+  switch (op) {
+  case OP_GT:
+    return value > threshold;
+  case OP_LT:
+    return value < threshold;
+  case OP_GE:
+    return value >= threshold;
+  case OP_LE:
+    return value <= threshold;
+  case OP_EQ:
+    return value == threshold;
+  default:
+    return value != threshold;
+  }
+}
+
+RuleEngine::RuleEngine() { reset(); }
+
+void RuleEngine::reset() {
+  memset(rules, 0, sizeof(rules));
+  memset(termSince, 0, sizeof(termSince));
+  memset(termTrue, 0, sizeof(termTrue));
+  memset(ruleSince, 0, sizeof(ruleSince));
+  memset(lastFired, 0, sizeof(lastFired));
+  memset(bySignalCount, 0, sizeof(bySignalCount));
+  count = 0;
+  ruleTrue = 0;
+  ruleLatched = 0;
+  ruleEverFired = 0;
+}
+
+bool RuleEngine::compile(const char *config, char *error, size_t errorLen) {
+  Cursor c = {config, 1, error, errorLen};
+
+  reset();
+  while (*c.p) {
+    if (atLineEnd(c) || *c.p == '#') {
+      // Blank line or comment
+      while (*c.p && *c.p != '\n') {
+        c.p++;
+      }
+    } else {
+      if (count == RULE_MAX_RULES) {
+        reset();
+        return fail(c, "too many rules");
+      }
+      Rule &rule = rules[count];
+
+      // name :
+      const char *name;
+      size_t nameLen = word(c, &name);
+      if (nameLen == 0 || nameLen >= RULE_NAME_LEN) {
+        reset();
+        return fail(c, "expected a rule name (max 23 characters)");
+      }
+      memcpy(rule.name, name, nameLen);
+      if (!accept(c, ":")) {
+        reset();
+        return fail(c, "expected ':' after the rule name");
+      }
+
+      // term [& term ...]
+      do {
+        if (rule.termCount == RULE_MAX_TERMS) {
+          reset();
+          return fail(c, "too many terms in rule");
+        }
+        Term &term = rule.terms[rule.termCount];
+
+        const char *sig;
+        size_t sigLen = word(c, &sig);
+        term.signal = SIGNAL_COUNT;
+        for (uint8_t s = 0; s < SIGNAL_COUNT; s++) {
+          if (strlen(signalNames[s]) == sigLen &&
+              strncmp(signalNames[s], sig, sigLen) == 0) {
+            term.signal = s;
+          }
+        }
+        if (term.signal == SIGNAL_COUNT) {
+          reset();
+          return fail(c, "unknown signal");
+        }
+        if (!comparison(c, &term.op) || !number(c, &term.threshold)) {
+          reset();
+          return false;
+        }
+        if (accept(c, "for") && !duration(c, &term.holdMs)) {
+          reset();
+          return false;
+        }
+
+        uint8_t &n = bySignalCount[term.signal];
+        bySignal[term.signal][n++] = count * RULE_MAX_TERMS + rule.termCount;
+        rule.termCount++;
+      } while (accept(c, "&"));
+
+      // [; debounce D] [; cooldown D]
+      while (accept(c, ";")) {
+        if (accept(c, "debounce")) {
+          if (!duration(c, &rule.debounceMs)) {
+            reset();
+            return false;
+          }
+        } else if (accept(c, "cooldown")) {
+          if (!duration(c, &rule.cooldownMs)) {
+            reset();
+            return false;
+          }
+        } else {
+          reset();
+          return fail(c, "expected 'debounce' or 'cooldown'");
+        }
+      }
+      if (!atLineEnd(c)) {
+        reset();
+        return fail(c, "unexpected text after rule");
+      }
+      count++;
+    }
+
+    if (*c.p == '\n') {
+      c.p++;
+      c.line++;
+    }
+  }
+  return true;
+}
+
+void RuleEngine::update(uint8_t signal, float value, uint32_t now) {
+  if (signal >= SIGNAL_COUNT) {
+    return;
+  }
+
+  // Only the terms that read this signal can change
+  for (uint8_t i = 0; i < bySignalCount[signal]; i++) {
+    uint8_t r = bySignal[signal][i] / RULE_MAX_TERMS;
+    uint8_t t = bySignal[signal][i] % RULE_MAX_TERMS;
+    const Term &term = rules[r].terms[t];
+    uint8_t bit = (uint8_t)(1u << t);
+
+    if (compare(term.op, value, term.threshold)) {
+      if (!(termTrue[r] & bit)) {
+        termTrue[r] |= bit;
+        termSince[r][t] = now;
+      }
+    } else {
+      termTrue[r] &= (uint8_t)~bit;
+    }
+  }
+}
+
+uint8_t RuleEngine::evaluate(uint32_t now, RuleAlertHandler onAlert) {
+  uint8_t fired = 0;
+
+  for (uint8_t r = 0; r < count; r++) {
+    const Rule &rule = rules[r];
+    uint16_t bit = (uint16_t)(1u << r);
+
+    // Every term must compare true and have held for its duration
+    bool holds = termTrue[r] == (uint8_t)((1u << rule.termCount) - 1);
+    for (uint8_t t = 0; holds && t < rule.termCount; t++) {
+      holds = now - termSince[r][t] >= rule.terms[t].holdMs;
+    }
+
+    if (!holds) {
+      ruleTrue &= (uint16_t)~bit;
+      ruleLatched &= (uint16_t)~bit;
+      continue;
+    }
+    if (!(ruleTrue & bit)) {
+      ruleTrue |= bit;
+      ruleSince[r] = now;
+    }
+
+    // Debounce, fire once per true period, and respect the cooldown
+    if ((ruleLatched & bit) || now - ruleSince[r] < rule.debounceMs ||
+        ((ruleEverFired & bit) && now - lastFired[r] < rule.cooldownMs)) {
+      continue;
+    }
+    ruleLatched |= bit;
+    ruleEverFired |= bit;
+    lastFired[r] = now;
+    fired++;
+    if (onAlert) {
+      onAlert(rule.name, now);
+    }
+  }
+  return fired;
+}
+
+uint8_t RuleEngine::ruleCount() const { return count; }
+
+const char *RuleEngine::ruleName(uint8_t index) const {
+  return index < count ? rules[index].name : nullptr;
+}
@@ -1,10 +1,22 @@
+#include "../include/AdaptiveSampler.hpp"
 #include "../include/DoorSensor.hpp"
+#include "../include/RuleEngine.hpp"
+#include "../include/SamplingConfig.hpp"
 #include "../include/bh1750.hpp"
 #include "../include/dht11.hpp"
-#include <PubSubClient.h>
+#include "../include/mmWave.hpp"
 #include <WiFi.h>
 #include <cstdio>
 
+// Transport is picked at build time; see the esp32dev-mqttsn env in
+// platformio.ini. MQTT-SN publishes over UDP through an MQTT-SN gateway.
+#ifdef MQTT_SN_TRANSPORT
+#include "../include/MqttSnClient.hpp"
+#include <WiFiUdp.h>
+#else
+#include <PubSubClient.h>
+#endif
+
 // WiFi Credentials
 const char *ssid = "IEEE Lab";
 const char *password = "IEEE@2025";
@@ -13,6 +25,23 @@ const char *password = "IEEE@2025";
 const char *mqttServer = "192.168.69.2";
 const int mqttPort = 1883;
 
+#ifdef MQTT_SN_TRANSPORT
+// MQTT-SN Gateway Settings (the gateway forwards to the broker above)
+const char *mqttSnGateway = "192.168.69.2";
+const uint16_t mqttSnPort = MQTTSN_DEFAULT_PORT;
+const uint16_t mqttSnKeepAlive = 60; // seconds
+
+// QoS -1 needs no session at all; 0 and 1 connect first
+#ifndef MQTT_SN_QOS
+#define MQTT_SN_QOS 0
+#endif
+
+// Sleeping clients stay awake unless the next reading is this far off (ms)
+#ifndef MQTT_SN_SLEEP_MIN_MS
+#define MQTT_SN_SLEEP_MIN_MS 15000
+#endif
+#endif
+
 // Create DHT11 interface instance
 DHT11Interface dht(DHTPIN);
 
@@ -24,12 +53,57 @@ DHT11Interface dht(DHTPIN);
 #define TEMP_TOPIC "Temperature"
 #define PRESSURE_TOPIC "Pressure"
 #define HUMIDITY_TOPIC "Humidity"
+#define FELT_TEMP "FeltTemperature"
+#define ALERT_TOPIC "Alert"
+#define OCCUPANCY_TOPIC "Occupancy"
+
+// Alert rules evaluated on the node; see RuleEngine.hpp for the syntax.
+// Presence comes from the mmWave radar once it has calibrated on an empty room.
+static const char *alertRules =
+    "lights_on_empty : lux > 300 & presence == 0 for 10m ; cooldown 15m\n"
+    "door_left_open  : door == 1 for 5m ; cooldown 10m\n"
+    "too_hot         : heatindex > 28 ; debounce 60s ; cooldown 30m\n"
+    "too_humid       : humidity > 70 ; debounce 60s ; cooldown 30m\n";
+
+RuleEngine rules;
 
+#ifdef MQTT_SN_TRANSPORT
+// Predefined MQTT-SN topic IDs; must match host/mqttsn/predefinedTopic.conf
+struct TopicId {
+  const char *topic;
+  uint16_t id;
+};
+
+static const TopicId topicIds[] = {
+    {ESP32_STATUS_TOPIC, 1}, {DOOR_TOPIC, 2},     {LUX_TOPIC, 3},
+    {MOTION_TOPIC, 4},       {TEMP_TOPIC, 5},     {PRESSURE_TOPIC, 6},
+    {HUMIDITY_TOPIC, 7},     {FELT_TEMP, 8},       {ALERT_TOPIC, 9},
+    {OCCUPANCY_TOPIC, 10},
+};
+
+WiFiUDP espUdp;
+MqttSnClient client(espUdp);
+#else
 WiFiClient espClient;
 PubSubClient client(espClient);
+#endif
+
+// Each sensor is read (and published) at its own adaptive rate: at its
+// minimum interval while readings change or after a door edge, backing off
+// to SAMPLE_BASE_INTERVAL_MS while the room is quiet. See SamplingConfig.hpp.
+static_assert(CLIMATE_MIN_INTERVAL_MS >= DHT11_MIN_INTERVAL_MS,
+              "climate sampling must respect the DHT11 minimum interval");
+AdaptiveSampler luxSampler(LUX_MIN_INTERVAL_MS, SAMPLE_BASE_INTERVAL_MS,
+                           LUX_THRESHOLD);
+AdaptiveSampler climateSampler(CLIMATE_MIN_INTERVAL_MS,
+                               SAMPLE_BASE_INTERVAL_MS, CLIMATE_THRESHOLD);
+
+bool lastDoorOpen = false;
 
-unsigned long lastPublish = 0;
-const unsigned long publishInterval = 5000; // 5 seconds
+// mmWave radar in report mode: per-gate energies processed on the node
+MmWaveFrameParser radarParser;
+MmWaveProcessor radar;
+MmWaveResult lastRadar = {};
 
 static void setupWiFi() {
   delay(100);
@@ -50,8 +124,46 @@ static void setupSensors() {
   initDoor();
   initBH1750();
   dht.begin();
+  init_mmWave(true);
+}
+
+#ifdef MQTT_SN_TRANSPORT
+static uint16_t topicIdFor(const char *topic) {
+  for (const TopicId &t : topicIds) {
+    if (strcmp(t.topic, topic) == 0) {
+      return t.id;
+    }
+  }
+  return 0;
 }
 
+static void reconnectMQTT() {
+  if (MQTT_SN_QOS < 0) {
+    return; // Connectionless publishing
+  }
+  while (!client.connected()) {
+    Serial.print("Connecting to MQTT-SN gateway...");
+    if (client.connect("ESP32Client", mqttSnKeepAlive)) {
+      Serial.println("connected!");
+    } else {
+      Serial.println("Failed, retrying in 5s...");
+      delay(5000);
+    }
+  }
+}
+
+// Publish data to the gateway and print error on failure
+static bool publishWithCheck(const char *topic, const char *payload) {
+  uint16_t id = topicIdFor(topic);
+  if (id != 0 && client.publish(id, payload, MQTT_SN_QOS)) {
+    return true;
+  } else {
+    Serial.print("Failed to publish to ");
+    Serial.println(topic);
+    return false;
+  }
+}
+#else
 static void reconnectMQTT() {
   while (!client.connected()) {
     Serial.print("Connecting to MQTT...");
@@ -77,33 +189,129 @@ static bool publishWithCheck(const char *topic, const char *payload) {
     return false;
   }
 }
+#endif
+
+// Publish an alert as soon as a rule fires, waking the session if needed
+static void publishAlert(const char *ruleName, uint32_t) {
+  if (!client.connected()) {
+    reconnectMQTT();
+  }
+  publishWithCheck(ALERT_TOPIC, ruleName);
+}
+
+static void setupRules() {
+  char error[64];
+  if (!rules.compile(alertRules, error, sizeof(error))) {
+    Serial.print("Alert rules disabled: ");
+    Serial.println(error);
+  }
+}
 
 void setup() {
   Serial.begin(115200);
   setupWiFi();
+#ifdef MQTT_SN_TRANSPORT
+  IPAddress gatewayIp;
+  gatewayIp.fromString(mqttSnGateway);
+  client.setGateway(gatewayIp, mqttSnPort);
+  reconnectMQTT();
+  publishWithCheck(ESP32_STATUS_TOPIC, "ESP32 Connected");
+#else
   client.setServer(mqttServer, mqttPort);
+#endif
   setupSensors();
+  setupRules();
 }
 
 void loop() {
+  unsigned long currentTime = millis();
+  char buffer[1024];
+
+  // The door is a plain GPIO read, so check it (and the rules) every tick
+  bool doorOpen = readDoor();
+  bool doorChanged = doorOpen != lastDoorOpen;
+  lastDoorOpen = doorOpen;
+  if (doorChanged) {
+    // Someone entering or leaving usually changes light and climate next
+    luxSampler.boost(currentTime);
+    climateSampler.boost(currentTime);
+  }
+  rules.update(SIG_DOOR, doorOpen ? 1 : 0, currentTime);
+
+  // Radar frames arrive several times a second; only changes are published
+  bool motionChanged = false, occupancyChanged = false;
+  if (readMmWaveFrame(radarParser)) {
+    MmWaveResult result;
+    radar.process(radarParser.frame(), &result);
+    if (!radar.calibrating()) {
+      if (result.presence != lastRadar.presence) {
+        luxSampler.boost(currentTime);
+        climateSampler.boost(currentTime);
+      }
+      motionChanged = result.presence != lastRadar.presence ||
+                      result.moving != lastRadar.moving;
+      occupancyChanged = result.targets != lastRadar.targets;
+      rules.update(SIG_PRESENCE, result.presence ? 1 : 0, currentTime);
+      lastRadar = result;
+    }
+  }
+  rules.evaluate(currentTime, publishAlert);
+
+  bool luxDue = luxSampler.due(currentTime);
+  bool climateDue = climateSampler.due(currentTime);
+
+#ifdef MQTT_SN_SLEEP
+  // A sleeping client only talks to the gateway when there is news; an
+  // awake one still needs loop() for its keep-alive pings
+  if (!doorChanged && !motionChanged && !occupancyChanged && !luxDue &&
+      !climateDue) {
+    if (client.connected()) {
+      client.loop();
+    }
+    delay(10);
+    return;
+  }
+#endif
   if (!client.connected()) {
     reconnectMQTT();
   }
   client.loop();
 
-  unsigned long currentTime = millis();
-  if (currentTime - lastPublish >= publishInterval) {
-    lastPublish = currentTime;
+  if (doorChanged || luxDue) {
+    publishWithCheck(DOOR_TOPIC, doorOpen ? "Open" : "Closed");
+  }
 
-    char buffer[1024];
+  if (motionChanged) {
+    publishWithCheck(MOTION_TOPIC, lastRadar.moving       ? "moving"
+                                   : lastRadar.presence ? "stationary"
+                                                        : "none");
+  }
 
-    snprintf(buffer, sizeof(buffer), "%u", computeLx());
+  if (occupancyChanged) {
+    snprintf(buffer, sizeof(buffer), "%u", lastRadar.targets);
+    publishWithCheck(OCCUPANCY_TOPIC, buffer);
+  }
+
+  if (luxDue) {
+    uint16_t lux = computeLx();
+    luxSampler.record(lux, currentTime);
+    rules.update(SIG_LUX, lux, currentTime);
+    snprintf(buffer, sizeof(buffer), "%u", lux);
     publishWithCheck(LUX_TOPIC, buffer);
+  }
 
-    publishWithCheck(DOOR_TOPIC, readDoor() ? "Open" : "Closed");
+  if (climateDue) {
+    float lastHumidity = dht.getHumidity();
 
     if (dht.read()) {
       // Successful reading
+      climateSampler.record(dht.getTemperature(), currentTime);
+      if (fabsf(dht.getHumidity() - lastHumidity) >= HUMIDITY_ACTIVITY) {
+        climateSampler.boost(currentTime);
+      }
+      rules.update(SIG_HUMIDITY, dht.getHumidity(), currentTime);
+      rules.update(SIG_TEMPERATURE, dht.getTemperature(), currentTime);
+      rules.update(SIG_HEAT_INDEX, dht.getHeatIndex(), currentTime);
 
       snprintf(buffer, sizeof(buffer), "%.2f", dht.getHumidity());
       publishWithCheck(HUMIDITY_TOPIC, buffer);
@@ -114,11 +322,27 @@ void loop() {
       snprintf(buffer, sizeof(buffer), "%.2f", dht.getHeatIndex());
       publishWithCheck(FELT_TEMP, buffer);
     } else {
-      // Failed reading
+      // Failed reading; retry no sooner than the current interval
+      climateSampler.missed(currentTime);
       Serial.println(F("Failed to read from DHT sensor!"));
     }
   }
 
+#ifdef MQTT_SN_SLEEP
+  // Let the gateway buffer downstream traffic until the next reading, but
+  // only once the samplers have backed off: waking costs a CONNECT/CONNACK
+  // and a DISCONNECT, far more than staying awake for a 1-2 s interval
+  if (client.connected()) {
+    uint32_t wake = luxSampler.nextDue();
+    if ((int32_t)(climateSampler.nextDue() - wake) < 0) {
+      wake = climateSampler.nextDue();
+    }
+    if ((int32_t)(wake - currentTime) >= MQTT_SN_SLEEP_MIN_MS) {
+      client.sleep((wake - currentTime) / 1000);
+    }
+  }
+#endif
+
   // Small delay to prevent watchdog issues
   delay(10);
 }
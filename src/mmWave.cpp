@@ -1,4 +1,4 @@
-#include "../include/mmWave.h"
+#include "../include/mmWave.hpp"
 #include <Arduino.h>
 
 // Original function to send command bytes - KEEP AS IS
@@ -59,9 +59,10 @@ int readAndProcessSensorLines() {
       return distance;
     }
   }
+  return -1;
 }
 
-void init_mmWave() {
+void init_mmWave(bool reportMode) {
   // start counting millis() from the moment the program starts
   unsigned long startAttemptTime = millis();
 
@@ -71,9 +72,25 @@ void init_mmWave() {
                  ", TX:" + String(TX2_PIN));
 
   // Send the command to the sensor (only done once)
-  String hex_to_send = "FDFCFBFA0800120000006400000004030201";
+  String hex_to_send =
+      reportMode ? MMWAVE_REPORT_MODE_CMD : MMWAVE_NORMAL_MODE_CMD;
   Serial.println("Sending initial command over Serial2...");
   sendHexData(hex_to_send);
   Serial.println("Initial command sent.");
   Serial.println("Waiting for sensor readings...");
 }
+
+/*
+ Feed the bytes waiting on Serial2 to the report frame parser. Stops as soon
+ as a frame is complete so the caller can process it before the next one,
+ and after MMWAVE_MAX_BYTES_PER_CALL bytes so loop() is never starved.
+ */
+bool readMmWaveFrame(MmWaveFrameParser &parser) {
+  for (int i = 0; i < MMWAVE_MAX_BYTES_PER_CALL && Serial2.available() > 0;
+       i++) {
+    if (parser.feed((uint8_t)Serial2.read())) {
+      return true;
+    }
+  }
+  return false;
+}
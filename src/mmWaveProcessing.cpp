@@ -0,0 +1,218 @@
+#include "../include/mmWaveProcessing.hpp"
+
+#include <math.h>
+#include <string.h>
+
+static const uint8_t frameHeader[4] = {0xF4, 0xF3, 0xF2, 0xF1};
+static const uint8_t frameTrailer[4] = {0xF8, 0xF7, 0xF6, 0xF5};
+
+// Header (4) + length field (2) + detected (1) + distance (2)
+#define FRAME_PREFIX 9
+
+// Payload sizes for 2-byte and 4-byte gate energies
+#define PAYLOAD_16BIT (3 + MMWAVE_GATES * 2)
+#define PAYLOAD_32BIT (3 + MMWAVE_GATES * 4)
+
+MmWaveFrameParser::MmWaveFrameParser() : pos(0), expected(0), rejected(0) {
+  memset(&current, 0, sizeof(current));
+}
+
+bool MmWaveFrameParser::feed(uint8_t b) {
+  // Hunt for the 4-byte header, restarting on the first mismatch
+  if (pos < 4) {
+    if (b == frameHeader[pos]) {
+      buf[pos++] = b;
+    } else {
+      pos = (b == frameHeader[0]) ? 1 : 0;
+      buf[0] = b;
+    }
+    return false;
+  }
+
+  buf[pos++] = b;
+  if (pos == 6) {
+    uint16_t len = (uint16_t)(buf[4] | (buf[5] << 8));
+    if (len != PAYLOAD_16BIT && len != PAYLOAD_32BIT) {
+      rejected++;
+      pos = 0;
+      return false;
+    }
+    expected = (uint16_t)(6 + len + 4);
+    return false;
+  }
+  if (pos < 6 || pos < expected) {
+    return false;
+  }
+
+  pos = 0;
+  if (memcmp(buf + expected - 4, frameTrailer, 4) != 0) {
+    rejected++;
+    return false;
+  }
+  return decode();
+}
+
+bool MmWaveFrameParser::feed(const uint8_t *data, size_t len, size_t *used) {
+  for (size_t i = 0; i < len; i++) {
+    if (feed(data[i])) {
+      *used = i + 1;
+      return true;
+    }
+  }
+  *used = len;
+  return false;
+}
+
+bool MmWaveFrameParser::decode() {
+  uint16_t len = (uint16_t)(buf[4] | (buf[5] << 8));
+  const uint8_t *e = buf + FRAME_PREFIX;
+
+  current.detected = buf[6] != 0;
+  current.distance = (uint16_t)(buf[7] | (buf[8] << 8));
+  if (len == PAYLOAD_16BIT) {
+    for (int g = 0; g < MMWAVE_GATES; g++, e += 2) {
+      current.energy[g] = (float)(uint16_t)(e[0] | (e[1] << 8));
+    }
+  } else {
+    for (int g = 0; g < MMWAVE_GATES; g++, e += 4) {
+      current.energy[g] = (float)((uint32_t)e[0] | ((uint32_t)e[1] << 8) |
+                                  ((uint32_t)e[2] << 16) |
+                                  ((uint32_t)e[3] << 24));
+    }
+  }
+  return true;
+}
+
+const MmWaveFrame &MmWaveFrameParser::frame() const { return current; }
+
+uint32_t MmWaveFrameParser::errors() const { return rejected; }
+
+/*
+        Per-gate kernels. Each one is a straight loop over fixed
+        MMWAVE_GATES-element arrays with no data-dependent branches,
+        so the compiler can vectorise them and the cost per frame
+        does not depend on what the radar sees.
+*/
+static inline void ema(float *avg, const float *x, float alpha) {
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    avg[g] += alpha * (x[g] - avg[g]);
+  }
+}
+
+static inline void absDiff(float *out, const float *a, const float *b) {
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    out[g] = fabsf(a[g] - b[g]);
+  }
+}
+
+static inline void subtractClamp(float *out, const float *a, const float *b) {
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    out[g] = fmaxf(a[g] - b[g], 0.0f);
+  }
+}
+
+// Bit g of the result is set where x[g] > k * noise[g] + offset[g]
+static inline uint16_t above(const float *x, const float *noise, float k,
+                             const float *offset) {
+  uint16_t mask = 0;
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    mask |= (uint16_t)((x[g] > k * noise[g] + offset[g]) << g);
+  }
+  return mask;
+}
+
+// Learn the empty-room energy and its typical deviation from it
+static inline void learnBackground(float *background, float *noise,
+                                   const float *x, float alpha) {
+  for (int g = 0; g < MMWAVE_GATES; g++) {
+    background[g] += alpha * (x[g] - background[g]);
+    float dev = fabsf(x[g] - background[g]);
+    noise[g] += alpha * (dev - noise[g]);
+    // Never let a perfectly quiet gate get a zero threshold
+    noise[g] = fmaxf(noise[g], 0.02f * background[g] + 1.0f);
+  }
+}
+
+static inline uint8_t countRuns(uint16_t mask) {
+  // A run starts wherever a bit is set and the one below it is not
+  return (uint8_t)__builtin_popcount(mask & ~(mask << 1));
+}
+
+MmWaveProcessor::MmWaveProcessor() {
+  memset(staticOffset, 0, sizeof(staticOffset));
+  recalibrate();
+}
+
+void MmWaveProcessor::recalibrate() {
+  memset(shortAvg, 0, sizeof(shortAvg));
+  memset(longAvg, 0, sizeof(longAvg));
+  memset(background, 0, sizeof(background));
+  memset(noise, 0, sizeof(noise));
+  memset(movingEnergy, 0, sizeof(movingEnergy));
+  memset(staticEnergy, 0, sizeof(staticEnergy));
+  frames = 0;
+  hold = 0;
+}
+
+bool MmWaveProcessor::calibrating() const {
+  return frames < MMWAVE_CALIBRATION_FRAMES;
+}
+
+void MmWaveProcessor::setStaticOffset(uint8_t gate, float offset) {
+  if (gate < MMWAVE_GATES) {
+    staticOffset[gate] = offset;
+  }
+}
+
+void MmWaveProcessor::process(const MmWaveFrame &frame, MmWaveResult *out) {
+  const float *x = frame.energy;
+
+  if (calibrating() && frame.detected) {
+    // Someone is in the room; learning now would take them for background
+    recalibrate();
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+  if (frames == 0) {
+    memcpy(shortAvg, x, sizeof(shortAvg));
+    memcpy(longAvg, x, sizeof(longAvg));
+    memcpy(background, x, sizeof(background));
+  }
+  ema(shortAvg, x, MMWAVE_ALPHA_SHORT);
+  ema(longAvg, x, MMWAVE_ALPHA_LONG);
+  absDiff(movingEnergy, shortAvg, longAvg);
+  subtractClamp(staticEnergy, longAvg, background);
+
+  memset(out, 0, sizeof(*out));
+  if (calibrating()) {
+    // Cumulative average converges quickly on the empty-room level
+    frames++;
+    learnBackground(background, noise, x, 1.0f / (float)frames);
+    return;
+  }
+
+  static const float noOffset[MMWAVE_GATES] = {0};
+  out->movingGates = above(movingEnergy, noise, MMWAVE_MOVING_K, noOffset);
+  out->activeGates = out->movingGates | above(staticEnergy, noise,
+                                              MMWAVE_STATIC_K, staticOffset);
+
+  if (out->activeGates) {
+    hold = MMWAVE_HOLD_FRAMES;
+  } else if (hold > 0) {
+    hold--;
+  }
+
+  out->presence = out->activeGates != 0 || hold > 0;
+  out->moving = out->movingGates != 0;
+  out->stationary = out->presence && !out->moving;
+  out->targets = countRuns(out->activeGates);
+  if (out->presence && out->targets == 0) {
+    out->targets = 1; // Held presence: someone is still there
+  }
+
+  // Only an empty room may move the background
+  if (!out->presence) {
+    learnBackground(background, noise, x, MMWAVE_ALPHA_BACKGROUND);
+  }
+  frames++;
+}